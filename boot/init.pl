@@ -1919,6 +1919,15 @@ compiling :-
 		     Stream, Parents, Options).
 '$term_in_file'(In, Read, RLayout, Term, TLayout, Stream, Parents, Options) :-
     '$skip_script_line'(In, Options),
+    (   '$parallel_load_option'(In, Parents, Options)
+    ->  '$parallel_directives'(In, Read, RLayout, Term, TLayout,
+			       Stream, Parents, Options)
+    ;   '$term_in_file_seq'(In, Read, RLayout, Term, TLayout,
+			    Stream, Parents, Options)
+    ).
+
+'$term_in_file_seq'(In, Read, RLayout, Term, TLayout, Stream, Parents,
+		    Options) :-
     '$read_clause_options'(Options, ReadOptions),
     '$repeat_and_read_error_mode'(ErrorMode),
       read_clause(In, Raw,
@@ -1942,6 +1951,395 @@ compiling :-
 			   Stream, Parents, Options)
       ).
 
+		 /*******************************
+		 *       PARALLEL LOADING       *
+		 *******************************/
+
+%!  '$parallel_load_option'(+In, +Parents, +Options) is semidet.
+%
+%   True if the load option parallel(Spec) asks for worker threads and
+%   In is a file stream that is not included and can be repositioned.
+
+'$parallel_load_option'(In, [_], Options) :-
+    '$option'(parallel(Spec), Options),
+    Spec \== false,
+    current_prolog_flag(threads, true),
+    '$parallel_load_workers'(Spec, Workers),
+    Workers > 1,
+    stream_property(In, file_name(_)),
+    stream_property(In, reposition(true)).
+
+%!  '$parallel_directives'(+In, -Read, -RLayout, -Term, -TLayout,
+%!                         -Stream, +Parents, +Options) is multi.
+%
+%   Process the directives at the start of the file sequentially as
+%   they may define operators, switch the module or change the
+%   encoding.  Parallel reading starts at the first other term.
+
+'$parallel_directives'(In, Read, RLayout, Term, TLayout, Stream, Parents,
+		       Options) :-
+    '$read_clause_options'(Options, ReadOptions),
+    '$repeat_and_read_error_mode'(ErrorMode),
+      stream_property(In, position(Here)),
+      read_clause(In, Raw,
+		  [ syntax_errors(ErrorMode),
+		    variable_names(Bindings),
+		    term_position(Pos),
+		    subterm_positions(RawLayout)
+		  | ReadOptions
+		  ]),
+      (   nonvar(Raw),
+	  Raw = (:- _)
+      ->  b_setval('$term_position', Pos),
+	  b_setval('$variable_names', Bindings),
+	  '$expanded_term'(In, Raw, RawLayout, Read, RLayout, Term, TLayout,
+			   Stream, Parents, Options)
+      ;   !,
+	  set_stream_position(In, Here),
+	  (   '$parallel_load'(In, Options, Ctx)
+	  ->  '$parallel_term_in_file'(In, Ctx, Read, RLayout, Term, TLayout,
+				       Stream, Parents, Options)
+	  ;   '$term_in_file_seq'(In, Read, RLayout, Term, TLayout,
+				  Stream, Parents, Options)
+	  )
+      ).
+
+%!  '$parallel_load'(+In, +Options, -Ctx) is semidet.
+%
+%   True if the remainder of In is read by worker threads.  This
+%   requires an encoding where a newline is a single byte and a file
+%   that is large enough to be split into chunks.
+
+'$parallel_load'(In, Options, Ctx) :-
+    '$option'(parallel(Spec), Options),
+    '$parallel_load_workers'(Spec, Workers),
+    stream_property(In, file_name(File)),
+    stream_property(In, encoding(Enc)),
+    '$parallel_load_encoding'(Enc),
+    size_file(File, Size),
+    stream_property(In, position(Pos)),
+    stream_position_data(byte_count, Pos, Start),
+    ChunkSize is max(0x10000, min(0x400000, Size//(Workers*4))),
+    Chunks is (Size-Start+ChunkSize-1)//ChunkSize,
+    Chunks > 1,
+    '$current_source_module'(Module),
+    Ctx = ctx(File, Enc, Module, Size, Start, Pos, ChunkSize, Chunks,
+	      Workers).
+
+'$parallel_load_workers'(true, N) :-
+    !,
+    current_prolog_flag(cpu_count, N).
+'$parallel_load_workers'(N, N) :-
+    integer(N),
+    N > 0,
+    !.
+'$parallel_load_workers'(Spec, _) :-
+    '$domain_error'(parallel, Spec).
+
+'$parallel_load_encoding'(utf8).
+'$parallel_load_encoding'(iso_latin_1).
+'$parallel_load_encoding'(ascii).
+'$parallel_load_encoding'(octet).
+'$parallel_load_encoding'(text).
+
+%!  '$parallel_term_in_file'(+In, +Ctx, -Read, -RLayout, -Term, -TLayout,
+%!                           -Stream, +Parents, +Options) is multi.
+%
+%   As '$term_in_file_seq'/8, but the file is split into chunks that
+%   end in a full stop followed by a newline.  Worker threads read the
+%   terms of the chunks.  The terms are expanded in source order by the
+%   loading thread.  A chunk is only used if the previous chunk ended
+%   exactly at its start.  If a worker finds a term that is not a ground
+%   fact, the chunk does not align or reading fails, we continue reading
+%   sequentially at the end of the last term that was read correctly.
+%   We also continue sequentially after a term that expands into a
+%   directive or a rule, as these may change how the remainder must be
+%   read.  Terms read past that point are discarded without expansion.
+
+%
+%   The workers read each chunk with a stream position that is relative
+%   to the start of the chunk.  State holds the absolute character count
+%   and line of the start of the current chunk to translate these into
+%   real positions, as well as the position where sequential reading
+%   must continue.
+
+'$parallel_term_in_file'(In, Ctx, Read, RLayout, Term, TLayout,
+			 Stream, Parents, Options) :-
+    arg(1, Ctx, File),
+    arg(6, Ctx, Pos0),
+    stream_position_data(char_count, Pos0, Char0),
+    stream_position_data(line_count, Pos0, Line0),
+    State = state(run, Pos0, 0, Char0, Line0),
+    (   setup_call_cleanup(
+	    '$parallel_load_start'(Ctx, Queues),
+	    '$parallel_terms'(Queues, Ctx, State, In, Read, RLayout,
+			      Term, TLayout, Stream, Parents, Options),
+	    '$parallel_load_stop'(Queues))
+    ;   arg(2, State, Pos),
+	arg(3, State, Count),
+	print_message(silent, load_file(parallel(File, Count))),
+	set_stream_position(In, Pos),
+	stream_position_data(line_count, Pos, Line),
+	'$set_source_location'(File, Line),
+	'$term_in_file_seq'(In, Read, RLayout, Term, TLayout,
+			    Stream, Parents, Options)
+    ).
+
+'$parallel_terms'(Queues, Ctx, State, In, Read, RLayout, Term, TLayout,
+		  Stream, Parents, Options) :-
+    arg(1, Ctx, File),
+    arg(8, Ctx, Chunks),
+    Max is Chunks-1,
+    between(0, Max, I),
+    arg(1, State, run),
+    '$parallel_chunk'(Queues, Ctx, I, Terms, Status),
+    arg(4, State, Char),
+    arg(5, State, Line),
+    '$parallel_chunk_done'(Status, State),
+    '$member'(t(RelStart, Raw, RelEnd), Terms),
+    \+ arg(1, State, done),
+    '$parallel_position'(RelStart, Char, Line, TermPos),
+    stream_position_data(line_count, TermPos, TermLine),
+    '$set_source_location'(File, TermLine),
+    b_setval('$term_position', TermPos),
+    b_setval('$variable_names', []),
+    arg(3, State, Count0),
+    Count is Count0+1,
+    nb_setarg(3, State, Count),
+    '$expanded_term'(In, Raw, _, Read, RLayout, Term, TLayout,
+		     Stream, Parents, Options),
+    (   Stream == In,
+	nonvar(Term),
+	\+ '$parallel_non_data'(Term)
+    ->  true
+    ;   '$parallel_position'(RelEnd, Char, Line, End),
+	nb_setarg(1, State, done),
+	nb_setarg(2, State, End)
+    ).
+
+%!  '$parallel_position'(+RelPos, +Char, +Line, -Pos) is det.
+%
+%   Translate a stream position relative to a chunk that starts at
+%   character Char and line Line into an absolute position.
+
+'$parallel_position'('$stream_position'(RelChar, RelLine, LinePos, Byte),
+		     Char, Line,
+		     '$stream_position'(AbsChar, AbsLine, LinePos, Byte)) :-
+    AbsChar is Char+RelChar,
+    AbsLine is Line+RelLine-1.
+
+'$parallel_chunk'(queues(Jobs, Results, _), Ctx, I, Terms, Status) :-
+    thread_get_message(Results, chunk(I, Terms, Status)),
+    arg(8, Ctx, Chunks),
+    arg(9, Ctx, Workers),
+    Next is I+2*Workers,
+    (   Next < Chunks
+    ->  '$parallel_job'(Jobs, Ctx, Next)
+    ;   true
+    ).
+
+'$parallel_chunk_done'(complete(Lines, Chars, Next), State) :-
+    !,
+    arg(4, State, Char0),
+    arg(5, State, Line0),
+    Char is Char0+Chars,
+    Line is Line0+Lines,
+    nb_setarg(2, State, '$stream_position'(Char, Line, 0, Next)),
+    nb_setarg(4, State, Char),
+    nb_setarg(5, State, Line).
+'$parallel_chunk_done'(eof(RelPos), State) :-
+    !,
+    '$parallel_stop'(eof, RelPos, State).
+'$parallel_chunk_done'(stop(RelPos), State) :-
+    !,
+    '$parallel_stop'(stop, RelPos, State).
+'$parallel_chunk_done'(failed, State) :-
+    nb_setarg(1, State, stop).
+
+'$parallel_stop'(Mode, RelPos, State) :-
+    arg(4, State, Char),
+    arg(5, State, Line),
+    '$parallel_position'(RelPos, Char, Line, Pos),
+    nb_setarg(1, State, Mode),
+    nb_setarg(2, State, Pos).
+
+'$parallel_job'(Jobs, Ctx, I) :-
+    Ctx = ctx(_File, _Enc, _Module, Size, Start, _Pos, ChunkSize, _, _),
+    From is Start+I*ChunkSize,
+    To is min(Size, From+ChunkSize),
+    thread_send_message(Jobs, job(I, From, To)).
+
+'$parallel_load_start'(Ctx, queues(Jobs, Results, Ids)) :-
+    arg(8, Ctx, Chunks),
+    arg(9, Ctx, Workers),
+    message_queue_create(Jobs),
+    message_queue_create(Results),
+    Ahead is min(Chunks, 2*Workers)-1,
+    forall(between(0, Ahead, I),
+	   '$parallel_job'(Jobs, Ctx, I)),
+    findall(Id,
+	    ( between(1, Workers, _),
+	      thread_create('$parallel_load_worker'(Jobs, Results, Ctx),
+			    Id, [])
+	    ),
+	    Ids).
+
+'$parallel_load_stop'(queues(Jobs, Results, Ids)) :-
+    message_queue_destroy(Jobs),
+    forall('$member'(Id, Ids),
+	   thread_join(Id, _)),
+    message_queue_destroy(Results).
+
+%!  '$parallel_load_worker'(+Jobs, +Results, +Ctx)
+%
+%   Thread that processes chunks until Jobs is destroyed.
+
+'$parallel_load_worker'(Jobs, Results, Ctx) :-
+    catch('$parallel_load_jobs'(Jobs, Results, Ctx), _, true).
+
+'$parallel_load_jobs'(Jobs, Results, Ctx) :-
+    thread_get_message(Jobs, job(I, From, To)),
+    (   catch('$load_chunk'(Ctx, I, From, To, Terms, Status), _, fail)
+    ->  true
+    ;   Terms = [],
+	Status = failed
+    ),
+    thread_send_message(Results, chunk(I, Terms, Status)),
+    '$parallel_load_jobs'(Jobs, Results, Ctx).
+
+%!  '$load_chunk'(+Ctx, +I, +From, +To, -Terms, -Status) is det.
+%
+%   Read the terms from the chunk that starts after the first full stop
+%   at or after From and ends with the first full stop at or after To.
+%   Terms is a list t(Start, Raw, End), where Start and End are the
+%   stream positions of the start of the term and just after it.  The
+%   character and line count of these positions are relative to the
+%   start of the chunk.  Status is one of
+%
+%     - complete(Lines, Chars, Next)
+%       The last term ends at the end of the chunk.  Lines and Chars
+%       are the number of lines and characters in the chunk and Next
+%       the byte offset of the next chunk.
+%     - eof(Pos)
+%       The chunk was read up to the end of the file at position Pos.
+%     - stop(Pos)
+%       Continue sequential reading at position Pos.
+
+'$load_chunk'(Ctx, I, From, To, Terms, Status) :-
+    Ctx = ctx(File, Enc, Module, Size, _, Pos0, _, _, _),
+    setup_call_cleanup(
+	open(File, read, B, [type(binary)]),
+	( (   I == 0
+	  ->  Start = From
+	  ;   '$chunk_boundary'(B, From, _, Start)
+	  ),
+	  (   To >= Size
+	  ->  End = eof
+	  ;   '$chunk_boundary'(B, To, EndDot, Next),
+	      (   EndDot == eof
+	      ->  End = eof
+	      ;   End = end(EndDot, Next)
+	      )
+	  )
+	),
+	close(B)),
+    (   I == 0
+    ->  stream_position_data(line_position, Pos0, LinePos)
+    ;   LinePos = 0
+    ),
+    StartPos = '$stream_position'(0, 1, LinePos, Start),
+    (   Start == eof
+    ->  Terms = [],
+	Status = eof('$stream_position'(0, 1, 0, Size))
+    ;   End = end(_, Start)
+    ->  Terms = [],
+	Status = complete(0, 0, Start)
+    ;   setup_call_cleanup(
+	    open(File, read, In, [encoding(Enc)]),
+	    ( set_stream_position(In, StartPos),
+	      '$read_chunk'(In, Module, End, StartPos, Terms, Status)
+	    ),
+	    close(In))
+    ).
+
+%!  '$chunk_boundary'(+Stream, +Offset, -Dot, -Next) is det.
+%
+%   Find the first full stop followed by a newline at or after Offset.
+%   Dot is the offset of the full stop and Next the offset just after
+%   the newline.  Both are `eof` if there is no such full stop.
+
+'$chunk_boundary'(B, Offset, Dot, Next) :-
+    seek(B, Offset, bof, _),
+    '$chunk_boundary'(B, Offset, -1, -1, Dot, Next).
+
+'$chunk_boundary'(B, P, C2, C1, Dot, Next) :-
+    get_byte(B, C),
+    (   C == -1
+    ->  Dot = eof,
+	Next = eof
+    ;   C == 0'\n, C1 == 0'.
+    ->  Dot is P-1,
+	Next is P+1
+    ;   C == 0'\n, C1 == 0'\r, C2 == 0'.
+    ->  Dot is P-2,
+	Next is P+1
+    ;   P1 is P+1,
+	'$chunk_boundary'(B, P1, C1, C, Dot, Next)
+    ).
+
+'$read_chunk'(In, Module, End, Pos0, Terms, Status) :-
+    (   catch(read_term(In, Raw,
+			[ module(Module),
+			  term_position(TermPos),
+			  syntax_errors(error)
+			]), _, fail)
+    ->  (   Raw == end_of_file
+	->  Terms = [],
+	    (   End == eof
+	    ->  stream_property(In, position(EofPos)),
+		Status = eof(EofPos)
+	    ;   Status = stop(Pos0)
+	    )
+	;   '$parallel_data_term'(Raw)
+	->  stream_property(In, position(Pos)),
+	    Terms = [t(TermPos, Raw, Pos)|Rest],
+	    stream_position_data(byte_count, Pos, Here),
+	    (   End = end(Dot, Next),
+		Here >= Dot+1
+	    ->  Rest = [],
+		(   Here =:= Dot+1
+		->  stream_position_data(char_count, Pos, Char),
+		    stream_position_data(line_count, Pos, Lines),
+		    Chars is Char+Next-Here,
+		    Status = complete(Lines, Chars, Next)
+		;   Status = stop(Pos)
+		)
+	    ;   '$read_chunk'(In, Module, End, Pos, Rest, Status)
+	    )
+	;   Terms = [],
+	    Status = stop(Pos0)
+	)
+    ;   Terms = [],
+	Status = stop(Pos0)
+    ).
+
+%!  '$parallel_data_term'(+Raw) is semidet.
+%
+%   True if Raw is a ground fact.  Term expansion is left to the
+%   loading thread, so it is never called for terms past a stop.
+
+'$parallel_data_term'(Raw) :-
+    ground(Raw),
+    \+ '$parallel_non_data'(Raw).
+
+'$parallel_non_data'((:- _)).
+'$parallel_non_data'((?- _)).
+'$parallel_non_data'((_ :- _)).
+'$parallel_non_data'((_ --> _)).
+'$parallel_non_data'((_ => _)).
+'$parallel_non_data'(end_of_file).
+
+
 '$read_clause_options'([], []).
 '$read_clause_options'([H|T0], List) :-
     (   '$read_clause_option'(H)
@@ -1168,6 +1168,19 @@ current_trie(Trie) :-
 %     - gen_call_count(Count)
 %       Number of trie_gen/2 calls on this trie
 %
+%   Answer table statistics:
+%
+%     - call_count(Count)
+%       Number of tabled calls that used this table
+%     - complete_call_count(Count)
+%       Number of these calls that found the table complete
+%     - answers_added(Count)
+%       Number of answers added to the table
+%     - duplicate_answers(Count)
+%       Number of answers rejected because they were already in the table
+%     - completion_time(Seconds)
+%       Wall time spent from starting the evaluation until completion
+%
 %   Incremental tabling statistics:
 %
 %     - invalidated(Count)
@@ -1195,6 +1208,11 @@ trie_property(compiled_size(_)).
                                                 % below only when -DO_TRIE_STATS
 trie_property(lookup_count(_)).                 % is enabled in pl-trie.h
 trie_property(gen_call_count(_)).
+trie_property(call_count(_)).                   % Answer table stats
+trie_property(complete_call_count(_)).
+trie_property(answers_added(_)).
+trie_property(duplicate_answers(_)).
+trie_property(completion_time(_)).
 trie_property(invalidated(_)).                  % IDG stats
 trie_property(reevaluated(_)).
 trie_property(deadlock(_)).                     % Shared tabling stats
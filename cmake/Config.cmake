@@ -30,12 +30,14 @@ check_include_file(shlobj.h HAVE_SHLOBJ_H)
 check_include_file(signal.h HAVE_SIGNAL_H)
 check_include_file(string.h HAVE_STRING_H)
 check_include_file(sys/dir.h HAVE_SYS_DIR_H)
+check_include_file(sys/epoll.h HAVE_SYS_EPOLL_H)
 check_include_file(sys/file.h HAVE_SYS_FILE_H)
 check_include_file(sys/mman.h HAVE_SYS_MMAN_H)
 check_include_file(sys/ndir.h HAVE_SYS_NDIR_H)
 check_include_file(sys/param.h HAVE_SYS_PARAM_H)
 check_include_file(sys/resource.h HAVE_SYS_RESOURCE_H)
 check_include_file(sys/select.h HAVE_SYS_SELECT_H)
+check_include_file(sys/sendfile.h HAVE_SYS_SENDFILE_H)
 check_include_file(sys/stat.h HAVE_SYS_STAT_H)
 check_include_file(sys/syscall.h HAVE_SYS_SYSCALL_H)
 check_include_file(sys/ioctl.h HAVE_SYS_IOCTL_H)
@@ -50,6 +52,7 @@ check_include_file(unistd.h HAVE_UNISTD_H)
 check_include_file(valgrind/valgrind.h HAVE_VALGRIND_VALGRIND_H)
 check_include_file(vfork.h HAVE_VFORK_H)
 check_include_file(mach/thread_act.h HAVE_MACH_THREAD_ACT_H)
+check_include_file(linux/io_uring.h HAVE_LINUX_IO_URING_H)
 check_include_file(sys/stropts.h HAVE_SYS_STROPTS_H)
 check_include_file(zlib.h HAVE_ZLIB_H)
 check_include_file(crt_externs.h HAVE_CRT_EXTERNS_H)
@@ -162,6 +165,9 @@ if(NOT EMSCRIPTEN)
 endif()
 check_function_exists(strerror HAVE_STRERROR)
 check_function_exists(poll HAVE_POLL)
+check_function_exists(copy_file_range HAVE_COPY_FILE_RANGE)
+check_function_exists(sendfile HAVE_SENDFILE)
+check_function_exists(splice HAVE_SPLICE)
 check_function_exists(getpwnam HAVE_GETPWNAM)
 check_function_exists(fork HAVE_FORK)
 check_function_exists(vfork HAVE_VFORK)
@@ -57,9 +57,6 @@
 :- autoload(library(error),[must_be/2,domain_error/2]).
 :- autoload(library(lists),[append/3]).
 :- autoload(library(option),[option/2,select_option/4]).
-:- autoload(library(pure_input),
-	    [phrase_from_file/3,phrase_from_stream/2]).
-:- autoload(library(readutil),[read_line_to_codes/2]).
 :- autoload(library(dcg/basics),[string//1,eos//0]).
 
 
@@ -82,13 +79,14 @@ have the same name and arity.
                        ignore_quotes(boolean),
                        convert(boolean),
                        case(oneof([down,preserve,up])),
+                       field_type(oneof([atom,string])),
                        functor(atom),
                        arity(-nonneg),          % actually ?nonneg
                        match_arity(boolean)
                      ]).
 :- predicate_options(csv_read_file/3, 3,
                      [ pass_to(csv//2, 2),
-                       pass_to(phrase_from_file/3, 3)
+                       pass_to(open/4, 4)
                      ]).
 :- predicate_options(csv_read_file_row/3, 3,
                      [ line(-integer),
@@ -110,6 +108,7 @@ have the same name and arity.
                 ignore_quotes:boolean=false,
                 convert:boolean=true,
                 case:oneof([down,preserve,up])=preserve,
+                field_type:oneof([atom,string])=atom,
                 functor:atom=row,
                 arity:integer,
                 match_arity:boolean=true,
@@ -121,9 +120,10 @@ have the same name and arity.
 %
 %   Read a CSV file into a list of   rows. Each row is a Prolog term
 %   with the same arity. Options  is   handed  to  csv//2. Remaining
-%   options  are  processed  by    phrase_from_file/3.  The  default
-%   separator depends on the file name   extension and is =|\t|= for
-%   =|.tsv|= files and =|,|= otherwise.
+%   options are processed by open/4.  The default separator depends on
+%   the file name extension and is =|\t|= for =|.tsv|= files and =|,|=
+%   otherwise.  The data is parsed by a  C implementation of the csv//2
+%   grammar that reads directly from the stream buffer.
 %
 %   Suppose we want to create a predicate   table/6  from a CSV file
 %   that we know contains 6 fields  per   record.  This  can be done
@@ -143,7 +143,10 @@ csv_read_file(File, Rows) :-
 csv_read_file(File, Rows, Options) :-
     default_separator(File, Options, Options1),
     make_csv_options(Options1, Record, RestOptions),
-    phrase_from_file(csv_roptions(Rows, Record), File, RestOptions).
+    setup_call_cleanup(
+        open(File, read, Stream, RestOptions),
+        csv_read_stream_rows(Stream, Rows, Record),
+        close(Stream)).
 
 
 default_separator(File, Options0, Options) :-
@@ -166,7 +169,103 @@ ext_separator(tsv, 0'\t).
 
 csv_read_stream(Stream, Rows, Options) :-
     make_csv_options(Options, Record, _),
-    phrase_from_stream(csv_roptions(Rows, Record), Stream).
+    csv_read_stream_rows(Stream, Rows, Record).
+
+csv_read_stream_rows(Stream, Rows, Record) :-
+    csv_skip_header(Stream, Record),
+    csv_row_flags(Record, 0, Functor, Sep, Flags),
+    csv_read_rows(Stream, Rows, Functor, Sep, Flags, Record).
+
+csv_read_rows(Stream, Rows, Functor, Sep, Flags, Record) :-
+    '$csv_read_row'(Stream, Row, Functor, Sep, Flags),
+    (   Row == end_of_file
+    ->  Rows = []
+    ;   functor(Row, _, Arity),
+        check_arity(Record, Arity),
+        Rows = [Row|More],
+        csv_read_rows(Stream, More, Functor, Sep, Flags, Record)
+    ).
+
+%!  csv_row_flags(+Record, +Flags0, -Functor, -Separator, -Flags) is det.
+%
+%   Translate the compiled options into   the  arguments for the C row
+%   reader '$csv_read_row'/5.
+
+csv_row_flags(Record, Flags0, Functor, Sep, Flags) :-
+    csv_options_functor(Record, Functor),
+    csv_options_separator(Record, Sep),
+    csv_options_strip(Record, Strip),
+    csv_options_ignore_quotes(Record, IgnoreQuotes),
+    csv_options_convert(Record, Convert),
+    csv_options_case(Record, Case),
+    csv_options_field_type(Record, Type),
+    flag_value(Strip, 0x01, F1),
+    flag_value(IgnoreQuotes, 0x02, F2),
+    flag_value(Convert, 0x04, F3),
+    case_flag(Case, F4),
+    type_flag(Type, F5),
+    Flags is Flags0 \/ F1 \/ F2 \/ F3 \/ F4 \/ F5.
+
+flag_value(true,  Flag, Flag).
+flag_value(false, _,    0).
+
+case_flag(preserve, 0).
+case_flag(down,     0x08).
+case_flag(up,       0x10).
+
+type_flag(atom,   0).
+type_flag(string, 0x20).
+
+%   csv_skip_header(+Stream, +Record) is det.
+%
+%   Implements the skip_header(CommentLead) option when reading from a
+%   stream, as skip_header//1 does for csv//2.
+
+csv_skip_header(Stream, Record) :-
+    csv_options_skip_header(Record, CommentStart),
+    nonvar(CommentStart),
+    !,
+    atom_length(CommentStart, Len),
+    stream_skip_header_lines(Stream, CommentStart, Len),
+    stream_skip_blank_lines(Stream).
+csv_skip_header(_, _).
+
+stream_skip_header_lines(Stream, CommentStart, Len) :-
+    peek_string(Stream, Len, Peek),
+    sub_atom(Peek, 0, Len, _, CommentStart),
+    !,
+    stream_skip_line(Stream),
+    stream_skip_header_lines(Stream, CommentStart, Len).
+stream_skip_header_lines(_, _, _).
+
+%   stream_skip_line(+Stream)
+%
+%   Skip to the end of the line, accepting the same line endings as
+%   end_of_record//0.
+
+stream_skip_line(Stream) :-
+    get_char(Stream, C),
+    (   C == '\n'
+    ->  true
+    ;   C == '\r'
+    ->  (   peek_char(Stream, '\n')
+        ->  get_char(Stream, _)
+        ;   true
+        )
+    ;   C == end_of_file
+    ->  true
+    ;   stream_skip_line(Stream)
+    ).
+
+stream_skip_blank_lines(Stream) :-
+    peek_char(Stream, C),
+    (   C == '\n'
+    ;   C == '\r'
+    ),
+    !,
+    get_char(Stream, _),
+    stream_skip_blank_lines(Stream).
+stream_skip_blank_lines(_).
 
 
 %!  csv(?Rows)// is det.
@@ -205,6 +304,10 @@ csv_read_stream(Stream, Rows, Options) :-
 %       If =down=, downcase atomic values.  If =up=, upcase them
 %       and if =preserve= (default), do not change the case.
 %
+%       * field_type(+Type)
+%       One of `atom` (default) or `string`.  Determines the type
+%       used for fields that are not converted to a number.
+%
 %       * functor(+Atom)
 %       Functor to use for creating row terms.  Default is =row=.
 %
@@ -373,27 +476,35 @@ field_codes([], _) --> [].              % unterminated last record
 make_value(Codes, Value, Options) :-
     csv_options_convert(Options, Convert),
     csv_options_case(Options, Case),
-    make_value(Convert, Case, Codes, Value).
+    csv_options_field_type(Options, Type),
+    make_value(Convert, Case, Type, Codes, Value).
 
-make_value(true, preserve, Codes, Value) :-
+make_value(true, preserve, atom, Codes, Value) :-
     !,
     name(Value, Codes).
-make_value(true, Case, Codes, Value) :-
+make_value(true, Case, Type, Codes, Value) :-
     !,
     (   number_string(Value, Codes)
     ->  true
-    ;   make_value(false, Case, Codes, Value)
+    ;   make_value(false, Case, Type, Codes, Value)
     ).
-make_value(false, preserve, Codes, Value) :-
+make_value(false, preserve, Type, Codes, Value) :-
     !,
-    atom_codes(Value, Codes).
-make_value(false, down, Codes, Value) :-
+    text_value(Type, Codes, Value).
+make_value(false, down, Type, Codes, Value) :-
     !,
     string_codes(String, Codes),
-    downcase_atom(String, Value).
-make_value(false, up, Codes, Value) :-
+    downcase_atom(String, Atom),
+    text_value(Type, Atom, Value).
+make_value(false, up, Type, Codes, Value) :-
     string_codes(String, Codes),
-    upcase_atom(String, Value).
+    upcase_atom(String, Atom),
+    text_value(Type, Atom, Value).
+
+text_value(atom, Text, Value) :-
+    atom_codes(Value, Text).
+text_value(string, Text, Value) :-
+    string_codes(Value, Text).
 
 separator(Options) -->
     { csv_options_separator(Options, Sep) },
@@ -447,38 +558,16 @@ csv_read_stream_row(Stream, Row, Line, Options) :-
 %   csv_options/2. Row is unified with   `end_of_file` upon reaching the
 %   end of the input.
 
-csv_read_row(Stream, Row, _Record) :-
-    at_end_of_stream(Stream),
-    !,
-    Row = end_of_file.
 csv_read_row(Stream, Row, Record) :-
-    read_lines_to_codes(Stream, Codes, Record, even),
-    phrase(row(Row0, Record), Codes),
-    !,
+    csv_row_flags(Record, 0x40, Functor, Sep, Flags),
+    '$csv_read_row'(Stream, Row0, Functor, Sep, Flags),
+    (   Row0 == end_of_file
+    ->  true
+    ;   functor(Row0, _, Arity),
+        check_arity(Record, Arity)
+    ),
     Row = Row0.
 
-read_lines_to_codes(Stream, Codes, Options, QuoteQuantity) :-
-    read_line_to_codes(Stream, Codes0),
-    Codes0 \== end_of_file,
-    (   (   csv_options_ignore_quotes(Options, true)
-        ;   check_quotes(Codes0, QuoteQuantity, even)
-        )
-    ->  Codes = Codes0
-    ;   append(Codes0, [0'\n|Tail], Codes),
-        read_lines_to_codes(Stream, Tail, Options, odd)
-    ).
-
-check_quotes([], QuoteQuantity, QuoteQuantity) :-
-    !.
-check_quotes([0'"|T], odd, Result) :-
-    !,
-    check_quotes(T, even, Result).
-check_quotes([0'"|T], even, Result) :-
-    !,
-    check_quotes(T, odd, Result).
-check_quotes([_|T], QuoteQuantity, Result) :-
-    check_quotes(T, QuoteQuantity, Result).
-
 
 %!  csv_options(-Compiled, +Options) is det.
 %
@@ -49,6 +49,7 @@
             incr_invalidate_call/1,		% :Goal
             incr_invalidate_calls/1,		% :Goal
             incr_table_update/0,
+            incr_batch_update/1,                % :Goal
 
             incr_propagate_calls/1              % :Answer
           ]).
@@ -81,6 +82,7 @@ corresponding database update.
     incr_is_invalid(:),
     incr_invalidate_call(:),
     incr_invalidate_calls(:),
+    incr_batch_update(0),
     incr_propagate_calls(:).
 
 incr_assert(T)     :- assertz(T).
@@ -204,6 +206,25 @@ incr_table_update :-
     ;   !
     ).
 
+%!  incr_batch_update(:Goal) is semidet.
+%
+%   Run Goal as once/1, delaying  the   invalidation  of tables that
+%   depend on incremental dynamic  predicates   modified  by Goal until
+%   Goal completes. Multiple modifications of   the  same dynamic node
+%   are merged into a single  traversal  of   the  IDG.  Tables that are
+%   called while Goal is  running  see  the   pending  changes.  This is
+%   also the default inside  transaction/1   and  snapshot/1.  The keys
+%   `idg_changes` and `idg_changes_coalesced` of statistics/2 report the
+%   number of changes and the number of  IDG propagations that merging
+%   avoided.  As repeated changes to   an already invalidated node stop
+%   immediately, the latter is often small.
+
+incr_batch_update(Goal) :-
+    setup_call_cleanup(
+        '$idg_batch_start'(Old),
+        once(Goal),
+        '$idg_batch_end'(Old)).
+
 %!  incr_propagate_calls(:Answer) is det.
 %
 %   Activate the monotonic answer propagation similarly   to  when a new
@@ -182,6 +182,7 @@ read_line_to_codes(C, Stream, [C|T], Tail) :-
 %
 %   @see    read_string/5 can be used to read lines with separated
 %           records without creating intermediate strings.
+%   @see    read_lines/3 reads many lines in a single call.
 
 read_line_to_string(Stream, String) :-
     read_string(Stream, '\n', '\r', Sep, String0),
@@ -53,6 +53,8 @@
             get_returns_for_call/2,             % :CallTerm, ?AnswerTerm
             get_residual/2,			% :CallTerm, -DelayList
 
+            table_statistics/2,                 % :Variant, -Stats
+
             set_pil_on/0,
             set_pil_off/0,
 
@@ -81,7 +83,8 @@ XSB predicates that are marked deprecated.
     get_calls(:, -, -),
     get_returns_for_call(:, :),
     get_returns_and_dls(+, -, :),
-    get_residual(:, -).
+    get_residual(:, -),
+    table_statistics(:, -).
 
 %!  't not'(:Goal)
 %
@@ -324,6 +327,47 @@ get_returns_for_call(CallTerm, M:AnswerTerm) :-
 		 *             TABLES		*
 		 *******************************/
 
+%!  table_statistics(:Variant, -Stats:dict) is nondet.
+%
+%   True when Stats is a dict  holding   performance  statistics for the
+%   answer table of Variant. This is  intended   to  find hot tables and
+%   decide which predicates are worth  tabling.   Stats  has  the keys
+%   below.  The counters are only  maintained if the system is compiled
+%   with `O_TRIE_STATS` (default).  See also trie_property/2.
+%
+%     - calls
+%       Number of tabled calls that used this table.
+%     - complete_calls
+%       Number of these calls that found the table complete.
+%     - answers
+%       Number of answers currently in the table.
+%     - answers_added
+%       Number of answers added to the table.
+%     - duplicate_answers
+%       Number of derived answers that were already in the table.
+%     - completion_time
+%       Wall time in seconds spent from starting the evaluation until
+%       the table was completed.
+%     - bytes
+%       Memory used by the answer trie.
+
+table_statistics(Variant, Stats) :-
+    current_table(Variant, Trie),
+    findall(Key-Value, table_statistic(Trie, Key, Value), Pairs),
+    dict_pairs(Stats, table_statistics, Pairs).
+
+table_statistic(Trie, Key, Value) :-
+    table_statistic_property(Key, Property, Value),
+    '$trie_property'(Trie, Property).
+
+table_statistic_property(calls,             call_count(V),          V).
+table_statistic_property(complete_calls,    complete_call_count(V), V).
+table_statistic_property(answers,           value_count(V),         V).
+table_statistic_property(answers_added,     answers_added(V),       V).
+table_statistic_property(duplicate_answers, duplicate_answers(V),   V).
+table_statistic_property(completion_time,   completion_time(V),     V).
+table_statistic_property(bytes,             size(V),                V).
+
 %!  abolish_table_pred(:CallTermOrPI)
 %
 %   Invalidates all tabled subgoals for  the   predicate  denoted by the
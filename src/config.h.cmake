@@ -29,6 +29,7 @@
 #cmakedefine HAVE_GETUID @HAVE_GETUID@
 #cmakedefine HAVE_CLOCK_GETTIME @HAVE_CLOCK_GETTIME@
 #cmakedefine HAVE_CONFSTR @HAVE_CONFSTR@
+#cmakedefine HAVE_COPY_FILE_RANGE @HAVE_COPY_FILE_RANGE@
 #cmakedefine HAVE_CRTDBG_H @HAVE_CRTDBG_H@
 #cmakedefine HAVE_CRT_EXTERNS_H @HAVE_CRT_EXTERNS_H@
 #cmakedefine HAVE_CTIME_R @HAVE_CTIME_R@
@@ -93,6 +94,7 @@
 #cmakedefine HAVE_LIBUNWIND @HAVE_LIBUNWIND@
 #cmakedefine HAVE_LIBWINMM @HAVE_LIBWINMM@
 #cmakedefine HAVE_LIBWSOCK32 @HAVE_LIBWSOCK32@
+#cmakedefine HAVE_LINUX_IO_URING_H @HAVE_LINUX_IO_URING_H@
 #cmakedefine HAVE_LOCALECONV @HAVE_LOCALECONV@
 #cmakedefine HAVE_LOCALE_H @HAVE_LOCALE_H@
 #cmakedefine HAVE_LOCALTIME_R @HAVE_LOCALTIME_R@
@@ -150,6 +152,7 @@
 #cmakedefine HAVE_SCHED_YIELD @HAVE_SCHED_YIELD@
 #cmakedefine HAVE_SC_NPROCESSORS_CONF @HAVE_SC_NPROCESSORS_CONF@
 #cmakedefine HAVE_SELECT @HAVE_SELECT@
+#cmakedefine HAVE_SENDFILE @HAVE_SENDFILE@
 #cmakedefine HAVE_SEMA_INIT @HAVE_SEMA_INIT@
 #cmakedefine HAVE_SEM_INIT @HAVE_SEM_INIT@
 #cmakedefine HAVE_SEM_TIMEDWAIT @HAVE_SEM_TIMEDWAIT@
@@ -170,6 +173,7 @@
 #cmakedefine HAVE_SIGPROCMASK @HAVE_SIGPROCMASK@
 #cmakedefine HAVE_SIGSET @HAVE_SIGSET@
 #cmakedefine HAVE_SIGSETMASK @HAVE_SIGSETMASK@
+#cmakedefine HAVE_SPLICE @HAVE_SPLICE@
 #cmakedefine HAVE_SIGALTSTACK @HAVE_SIGALTSTACK@
 #cmakedefine HAVE_SLEEP @HAVE_SLEEP@
 #cmakedefine HAVE_SRAND @HAVE_SRAND@
@@ -192,12 +196,14 @@
 #cmakedefine HAVE_SYSCONF @HAVE_SYSCONF@
 #cmakedefine HAVE_SYSCTLBYNAME @HAVE_SYSCTLBYNAME@
 #cmakedefine HAVE_SYS_DIR_H @HAVE_SYS_DIR_H@
+#cmakedefine HAVE_SYS_EPOLL_H @HAVE_SYS_EPOLL_H@
 #cmakedefine HAVE_SYS_FILE_H @HAVE_SYS_FILE_H@
 #cmakedefine HAVE_SYS_MMAN_H @HAVE_SYS_MMAN_H@
 #cmakedefine HAVE_SYS_NDIR_H @HAVE_SYS_NDIR_H@
 #cmakedefine HAVE_SYS_PARAM_H @HAVE_SYS_PARAM_H@
 #cmakedefine HAVE_SYS_RESOURCE_H @HAVE_SYS_RESOURCE_H@
 #cmakedefine HAVE_SYS_SELECT_H @HAVE_SYS_SELECT_H@
+#cmakedefine HAVE_SYS_SENDFILE_H @HAVE_SYS_SENDFILE_H@
 #cmakedefine HAVE_SYS_STAT_H @HAVE_SYS_STAT_H@
 #cmakedefine HAVE_SYS_STROPTS_H @HAVE_SYS_STROPTS_H@
 #cmakedefine HAVE_SYS_SYSCALL_H @HAVE_SYS_SYSCALL_H@
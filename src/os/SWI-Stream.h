@@ -155,6 +155,7 @@ stuff.
 #define EPLEXCEPTION	1001		/* errno: pending Prolog exception */
 
 #define SIO_BUFSIZE	(4096)		/* buffering buffer-size */
+#define SIO_BUFMAX	(1024*1024)	/* limit for adaptive buffers */
 #define SIO_LINESIZE	(1024)		/* Sgets() default buffer size */
 #define SIO_OMAGIC	(7212676)	/* old magic number */
 #define SIO_MAGIC	(7212677)	/* magic number */
@@ -250,7 +251,9 @@ typedef struct io_stream
   void *		context;	/* getStreamContext() */
   struct PL_locale *	locale;		/* Locale associated to stream */
   intptr_t		fileno;		/* File number if this is associated to a file */
-  intptr_t		reserved[3];	/* reserved for extension */
+  intptr_t		owner;		/* Owning thread (Sset_owner()) */
+  intptr_t		bufmax;		/* Adaptive buffer limit (0: fixed) */
+  intptr_t		reserved[1];	/* reserved for extension */
 } IOSTREAM;
 
 
@@ -424,6 +427,8 @@ PL_EXPORT(void)		SinitStreams(void);
 PL_EXPORT(void)		Scleanup(void);
 PL_EXPORT(void)		Sreset(void);
 PL_EXPORT(int)		S__fupdatefilepos_getc(IOSTREAM *s, int c);
+PL_EXPORT(void)		S__fupdatefilepos_span(IOSTREAM *s,
+					       const char *q, size_t len);
 PL_EXPORT(int)		S__fillbuf(IOSTREAM *s);
 PL_EXPORT(int)		Sset_timeout(IOSTREAM *s, int tmo);
 PL_EXPORT(int)		Sunit_size(IOSTREAM *s);
@@ -436,6 +441,12 @@ PL_EXPORT(int)		Scanrepresent(int c, IOSTREAM *s);
 PL_EXPORT(int)		Sputcode(int c, IOSTREAM *s);
 PL_EXPORT(int)		Sgetcode(IOSTREAM *s);
 PL_EXPORT(int)		Speekcode(IOSTREAM *s);
+PL_EXPORT(size_t)	Sfetch_ascii(IOSTREAM *s, const char *stop, size_t max,
+				     const char **start);
+PL_EXPORT(size_t)	Sfetch_ascii_to(IOSTREAM *s, int sep, size_t max,
+					const char **start);
+PL_EXPORT(int)		Sputs_latin1(const char *q, size_t len, IOSTREAM *s);
+PL_EXPORT(int)		Sputs_wchar(const wchar_t *q, size_t len, IOSTREAM *s);
 					/* word I/O */
 PL_EXPORT(int)		Sputw(int w, IOSTREAM *s);
 PL_EXPORT(int)		Sgetw(IOSTREAM *s);
@@ -482,6 +493,7 @@ PL_EXPORT(int)		SdprintfX(const char *fm, ...);
 PL_EXPORT(int)		Slock(IOSTREAM *s);
 PL_EXPORT(int)		StryLock(IOSTREAM *s);
 PL_EXPORT(int)		Sunlock(IOSTREAM *s);
+PL_EXPORT(int)		Sset_owner(IOSTREAM *s, int own);
 PL_EXPORT(IOSTREAM *)	Snew(void *handle, int flags, IOFUNCTIONS *functions);
 PL_EXPORT(IOSTREAM *)	Sopen_file(const char *path, const char *how);
 PL_EXPORT(IOSTREAM *)	Sopen_iri_or_file(const char *path, const char *how);
@@ -502,6 +514,9 @@ PL_EXPORT(int)		Sclosehook(void (*hook)(IOSTREAM *s));
 PL_EXPORT(void)		Sfree(void *ptr);
 PL_EXPORT(int)		Sset_filter(IOSTREAM *parent, IOSTREAM *filter);
 PL_EXPORT(void)		Ssetbuffer(IOSTREAM *s, char *buf, size_t size);
+PL_EXPORT(void)		Sset_default_buffer_size(size_t size, size_t max);
+PL_EXPORT(size_t)	Sdefault_buffer_size(size_t *max);
+PL_EXPORT(void)		Sstream_pool_statistics(size_t *hits, size_t *misses);
 
 PL_EXPORT(int64_t)	Stell64(IOSTREAM *s);
 PL_EXPORT(int)		Sseek64(IOSTREAM *s, int64_t pos, int whence);
@@ -134,7 +134,7 @@ character is  not lower if `ftoupper(c)  != c`.  This too  is somewhat
 dubious.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-static int
+int
 ftoupper(int chr)
 {
 #if SIZEOF_WINT_T == 2
@@ -150,7 +150,7 @@ ftoupper(int chr)
   return towupper(chr);
 }
 
-static int
+int
 ftolower(int chr)
 {
 #if SIZEOF_WINT_T == 2
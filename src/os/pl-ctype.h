@@ -44,6 +44,8 @@
 IOENC		initEncoding(void);
 void		initCharTypes(void);
 access_level_t	setAccessLevel(access_level_t new_level);
+int		ftoupper(int chr);
+int		ftolower(int chr);
 
 extern const char _PL_char_types[];	/* array of character types */
 
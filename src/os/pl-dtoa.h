@@ -44,6 +44,8 @@
 COMMON(char *)	dtoa(double dd, int mode, int ndigits,
 		     int *decpt, int *sign, char **rve);
 COMMON(void)	freedtoa(char *s);
+COMMON(int)	dtoa_shortest(double f, char *digits, int *decpt, int *sign);
 double		strtod(const char *in, char **end);
+COMMON(bool)	strtod_fast(const char *s, const char *e, double *dp);
 
 #endif /*PL_DTOA_H_INCLUDED*/
@@ -640,6 +640,17 @@ symbol_not_a_stream(atom_t symbol)
 }
 
 
+static bool
+symbol_not_owner(atom_t symbol)
+{ GET_LD
+  term_t t = PL_new_term_ref();
+  PL_put_atom(t, symbol);
+
+  return PL_error(NULL, 0, "stream is owned by another thread",
+		  ERR_PERMISSION, ATOM_access, ATOM_stream, t);
+}
+
+
 static bool
 symbol_stream_pair_not_allowed(atom_t symbol)
 { GET_LD
@@ -836,11 +847,13 @@ get_stream_handle(DECL_LD atom_t a, IOSTREAM **sp, int flags)
 	return true;
       } else
 	return false;			/* exception */
-    } else if ( (s=getStream(s)) )
+    } else if ( getStream(s) )
     { *sp = s;
       return true;
     }
 
+    if ( s->owner && errno == EPERM )
+      return symbol_not_owner(a);
     return symbol_no_stream(a);
   } else
   { void *s0;
@@ -1519,6 +1532,34 @@ closeFiles(int all)
 }
 
 
+/* releaseOwnedStreams() is called by a terminating thread to give up
+ * ownership of the streams it still owns.  Otherwise these streams can
+ * no longer be used, or are owned by the next thread that gets the
+ * same id.
+ */
+
+void
+releaseOwnedStreams(void)
+{ GET_LD
+  int self = PL_thread_self();
+  TableEnum e;
+  table_key_t tk;
+
+  if ( !LD->IO.owns_streams || !streamContext || self <= 0 )
+    return;
+
+  e = newTableEnumPP(streamContext);
+  while( advanceTableEnum(e, &tk, NULL) )
+  { IOSTREAM *s = key2ptr(tk);
+
+    if ( s->owner == self )
+      Sset_owner(s, false);
+  }
+  freeTableEnum(e);
+  LD->IO.owns_streams = false;
+}
+
+
 void
 protocol(const char *str, size_t n)
 { GET_LD
@@ -1717,7 +1758,7 @@ setupOutputRedirect(term_t to, redir_context *ctx, int redir)
     ctx->data = ctx->buffer;
     ctx->size = sizeof(ctx->buffer);
     ctx->stream = Sopenmem(&ctx->data, &ctx->size, "w");
-    ctx->stream->encoding = ENC_WCHAR;
+    ctx->stream->encoding = ENC_UTF8;	/* allows for bulk ASCII output */
   }
 
   ctx->magic = REDIR_MAGIC;
@@ -1748,6 +1789,7 @@ closeOutputRedirect(redir_context *ctx)
   { GET_LD
     term_t out  = PL_new_term_ref();
     term_t diff, tail;
+    PL_chars_t text;
 
     if ( Sclose(ctx->stream) == 0 )
     { _PL_get_arg(1, ctx->term, out);
@@ -1759,9 +1801,14 @@ closeOutputRedirect(redir_context *ctx)
       { diff = tail = 0;
       }
 
-      rval = PL_unify_wchars_diff(out, tail, ctx->out_format,
-				  ctx->size/sizeof(wchar_t),
-				  (wchar_t*)ctx->data);
+      text.text.t    = ctx->data;
+      text.encoding  = ENC_UTF8;
+      text.storage   = PL_CHARS_HEAP;
+      text.length    = ctx->size;
+      text.canonical = false;
+
+      rval = PL_unify_text(out, tail, &text, ctx->out_format);
+      PL_free_text(&text);
       if ( rval && tail )
 	rval = PL_unify(tail, diff);
     } else
@@ -2413,6 +2460,29 @@ set_stream(DECL_LD IOSTREAM *s, term_t stream, atom_t aname, term_t a)
 }
 
 
+/* set_stream(S, owned(Bool)).  Sset_owner() may not be called with the
+ * stream locked, so this is not handled by set_stream().
+ */
+
+#define set_stream_owned(stream, a) LDFUNC(set_stream_owned, stream, a)
+static int
+set_stream_owned(DECL_LD term_t stream, term_t a)
+{ IOSTREAM *s;
+  int own;
+
+  if ( !PL_get_bool_ex(a, &own) ||
+       !term_stream_handle(stream, &s, SH_ERRORS|SH_ALIAS|SH_UNLOCKED) )
+    return false;
+
+  if ( Sset_owner(s, own) == 0 )
+  { if ( own )
+      LD->IO.owns_streams = true;
+    return true;
+  }
+  return PL_permission_error("own", "stream", stream);
+}
+
+
 typedef struct set_stream_info
 { atom_t name;
   int    flags;
@@ -2444,6 +2514,7 @@ static const set_stream_info ss_info[] =
   SS_INFO(ATOM_write_errors,          SS_WRITE),
   SS_INFO(ATOM_newline,		      SS_BOTH),
   SS_INFO(ATOM_close_on_exec,	      SS_BOTH),
+  SS_INFO(ATOM_owned,		      SS_EITHER),
   SS_INFO((atom_t)0,		      0)
 };
 
@@ -2474,6 +2545,8 @@ PRED_IMPL("set_stream", 2, set_stream, 0)
 
 found:
   _PL_get_arg(1, attr, aval);
+  if ( aname == ATOM_owned )
+    return set_stream_owned(stream, aval);
 
   if ( !PL_get_atom(stream, &sblob) )
     return not_a_stream(stream);
@@ -2633,10 +2706,52 @@ typedef struct fdentry
 #define ACTION_WAIT ATOM_select
 #endif
 
+#ifdef HAVE_POLL
+/* Translate the wait_for_input/3 timeout into milliseconds for poll()
+ */
+
+static int
+get_poll_timeout(term_t timeout, int *to)
+{ GET_LD
+  atom_t a;
+  double time;
+
+  if ( PL_get_atom(timeout, &a) && a == ATOM_infinite )
+  { *to = -1;
+  } else if ( PL_is_integer(timeout) )
+  { int i;
+
+    if ( PL_get_integer(timeout, &i) )
+    { if ( i <= 0 )
+      { *to = 0;
+      } else if ( (int64_t)i*1000 <= INT_MAX )
+      { *to = i*1000;
+      } else
+      { return PL_representation_error("timeout");
+      }
+    } else
+    { return PL_representation_error("timeout");
+    }
+  } else if ( PL_get_float_ex(timeout, &time) )
+  { if ( time > 0.0 )
+    { if ( time * 1000.0 <= (double)INT_MAX )
+      { *to = (int)(time*1000.0);
+      } else
+      { return PL_domain_error("timeout", timeout);
+      }
+    } else
+    { *to = 0;
+    }
+  } else
+    return false;
+
+  return true;
+}
+#endif
+
 static
 PRED_IMPL("wait_for_input", 3, wait_for_input, 0)
 { PRED_LD
-  double time;
   fdentry map_buf[FASTMAP_SIZE];
   fdentry *map;
 #ifdef HAVE_POLL
@@ -2647,13 +2762,14 @@ PRED_IMPL("wait_for_input", 3, wait_for_input, 0)
   SOCKET max = 0;
   fd_set fds;
   struct timeval t, *to;
+  double time;
+  atom_t a;
 #endif
   term_t head      = PL_new_term_ref();
   term_t streams   = PL_copy_term_ref(A1);
   term_t available = PL_copy_term_ref(A2);
   term_t ahead     = PL_new_term_ref();
   int from_buffer  = 0;
-  atom_t a;
   size_t count;
   int i, nfds;
   int rc = false;
@@ -2743,36 +2859,7 @@ PRED_IMPL("wait_for_input", 3, wait_for_input, 0)
   }
 
 #ifdef HAVE_POLL
-  if ( PL_get_atom(timeout, &a) && a == ATOM_infinite )
-  { to = -1;
-  } else if ( PL_is_integer(timeout) )
-  { int i;
-
-    if ( PL_get_integer(timeout, &i) )
-    { if ( i <= 0 )
-      { to = 0;
-      } else if ( (int64_t)i*1000 <= INT_MAX )
-      { to = i*1000;
-      } else
-      { PL_representation_error("timeout");
-	goto out;
-      }
-    } else
-    { PL_representation_error("timeout");
-      goto out;
-    }
-  } else if ( PL_get_float_ex(timeout, &time) )
-  { if ( time > 0.0 )
-    { if ( time * 1000.0 <= (double)INT_MAX )
-      { to = (int)(time*1000.0);
-      } else
-      { PL_domain_error("timeout", timeout);
-	goto out;
-      }
-    } else
-    { to = 0;
-    }
-  } else
+  if ( !get_poll_timeout(timeout, &to) )
     goto out;
 #else /*HAVE_POLL*/
   if ( PL_get_atom(timeout, &a) && a == ATOM_infinite )
@@ -2867,6 +2954,451 @@ out:
 #endif /* HAVE_SELECT */
 
 
+		/********************************
+		*	 PERSISTENT POLLERS	*
+		********************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A poller is a persistent set of streams to wait for.  Unlike
+wait_for_input/3, which builds a poll() array on every call, streams
+are registered once with an epoll instance, so poller_wait/3 costs
+O(ready) rather than O(streams).
+
+As wait_for_input/3, we must report streams that have input in their
+buffer.  Such a stream must have been read after it was added or
+reported ready, so we only check the streams on the `check` list,
+which holds the streams added and reported since the last wait.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_POLL)
+#include <sys/epoll.h>
+#define HAVE_PRED_POLLER 1
+
+#define POLLER_MAX_EVENTS 256
+
+typedef struct poll_entry
+{ atom_t	stream;			/* Stream handle or alias (or 0) */
+  record_t	data;			/* Reported by poller_wait/3 */
+  unsigned int	reported;		/* Generation we were last reported */
+} poll_entry;
+
+typedef struct poller
+{ int		epfd;			/* The epoll instance */
+  atom_t	symbol;			/* <poller>(%p) */
+  poll_entry  **entries;		/* Indexed by file descriptor */
+  int		size;			/* Allocated size of entries */
+  int	       *check;			/* Check for buffered input */
+  int		check_count;		/* Entries in check */
+  int		check_size;		/* Allocated size of check */
+  unsigned int	generation;		/* Incremented by poller_wait/3 */
+#ifdef O_PLMT
+  simpleMutex	mutex;
+#endif
+} poller;
+
+#ifdef O_PLMT
+#define LOCK_POLLER(p)   simpleMutexLock(&(p)->mutex)
+#define UNLOCK_POLLER(p) simpleMutexUnlock(&(p)->mutex)
+#else
+#define LOCK_POLLER(p)   (void)0
+#define UNLOCK_POLLER(p) (void)0
+#endif
+
+static void
+free_poll_entry(poll_entry *e)
+{ if ( e->stream )
+    PL_unregister_atom(e->stream);
+  if ( e->data )
+    PL_erase(e->data);
+  free(e);
+}
+
+static int
+write_poller(IOSTREAM *s, atom_t aref, int flags)
+{ poller *p = PL_blob_data(aref, NULL, NULL);
+  (void)flags;
+
+  Sfprintf(s, "<poller>(%p)", p);
+  return true;
+}
+
+static void
+acquire_poller(atom_t aref)
+{ poller *p = PL_blob_data(aref, NULL, NULL);
+
+  p->symbol = aref;
+}
+
+static int
+release_poller(atom_t aref)
+{ poller *p = PL_blob_data(aref, NULL, NULL);
+  int i;
+
+  if ( p->epfd >= 0 )
+    close(p->epfd);
+  for(i=0; i<p->size; i++)
+  { if ( p->entries[i] )
+      free_poll_entry(p->entries[i]);
+  }
+  free(p->entries);
+  free(p->check);
+#ifdef O_PLMT
+  simpleMutexDelete(&p->mutex);
+#endif
+  free(p);
+
+  return true;
+}
+
+static int
+save_poller(atom_t aref, IOSTREAM *fd)
+{ poller *p = PL_blob_data(aref, NULL, NULL);
+  (void)fd;
+
+  return PL_warning("Cannot save reference to <poller>(%p)", p);
+}
+
+static atom_t
+load_poller(IOSTREAM *fd)
+{ (void)fd;
+
+  return PL_new_atom("<poller>");
+}
+
+static PL_blob_t poller_blob =
+{ PL_BLOB_MAGIC,
+  PL_BLOB_NOCOPY,
+  "poller",
+  release_poller,
+  NULL,
+  write_poller,
+  acquire_poller,
+  save_poller,
+  load_poller
+};
+
+static int
+get_poller(term_t t, poller **pp)
+{ GET_LD
+  void *data;
+  PL_blob_t *type;
+
+  if ( PL_get_blob(t, &data, NULL, &type) && type == &poller_blob )
+  { *pp = data;
+    return true;
+  }
+
+  return PL_type_error("poller", t);
+}
+
+/* Get the file descriptor to wait for.  If `t` is a stream, `stream`
+ * is the stream handle or alias.
+ */
+
+static int
+get_poll_fd(term_t t, int *fdp, atom_t *stream)
+{ GET_LD
+  IOSTREAM *s;
+  int fd;
+
+  if ( PL_get_integer(t, &fd) )
+  { *stream = 0;
+  } else
+  { if ( !PL_get_stream(t, &s, SIO_INPUT) )
+      return false;
+    fd = Sfileno(s);
+    releaseStream(s);
+    if ( fd < 0 || !PL_get_atom(t, stream) )
+      return PL_domain_error("waitable_stream", t);
+  }
+
+  if ( fd < 0 )
+    return PL_domain_error("file_descriptor", t);
+  *fdp = fd;
+
+  return true;
+}
+
+static int
+poller_check(poller *p, int fd)
+{ if ( p->check_count == p->check_size )
+  { int size = p->check_size ? p->check_size*2 : 16;
+    int *new = realloc(p->check, size*sizeof(*new));
+
+    if ( !new )
+      return false;
+    p->check = new;
+    p->check_size = size;
+  }
+  p->check[p->check_count++] = fd;
+
+  return true;
+}
+
+static
+PRED_IMPL("poller_create", 1, poller_create, 0)
+{ PRED_LD
+  poller *p;
+
+  if ( !(p = calloc(1, sizeof(*p))) )
+    return PL_no_memory();
+  if ( (p->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0 )
+  { free(p);
+    return PL_error(NULL, 0, MSG_ERRNO, ERR_SYSCALL, "epoll_create");
+  }
+#ifdef O_PLMT
+  simpleMutexInit(&p->mutex);
+#endif
+
+  return PL_unify_blob(A1, p, sizeof(*p), &poller_blob);
+}
+
+/** poller_add(+Poller, +Stream, +Data)
+ * Add Stream (or file descriptor) to Poller, such that poller_wait/3
+ * returns Data if Stream has input.  If Stream is already part of
+ * Poller, just replace Data.
+ */
+
+static
+PRED_IMPL("poller_add", 3, poller_add, 0)
+{ PRED_LD
+  poller *p = NULL;
+  poll_entry *e, *old;
+  atom_t stream;
+  int fd;
+  int rc = true;
+
+  if ( !get_poller(A1, &p) ||
+       !get_poll_fd(A2, &fd, &stream) )
+    return false;
+
+  if ( !(e = calloc(1, sizeof(*e))) ||
+       !(e->data = PL_record(A3)) )
+  { free(e);
+    return PL_no_memory();
+  }
+  if ( (e->stream = stream) )
+    PL_register_atom(stream);
+
+  LOCK_POLLER(p);
+  if ( fd >= p->size )
+  { int size = p->size ? p->size : 64;
+    poll_entry **new;
+
+    while( fd >= size )
+      size *= 2;
+    if ( !(new = realloc(p->entries, size*sizeof(*new))) )
+    { rc = PL_no_memory();
+      goto out;
+    }
+    memset(new+p->size, 0, (size-p->size)*sizeof(*new));
+    p->entries = new;
+    p->size = size;
+  }
+
+  { struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+
+    if ( epoll_ctl(p->epfd, EPOLL_CTL_ADD, fd, &ev) < 0 &&
+	 (errno != EEXIST || epoll_ctl(p->epfd, EPOLL_CTL_MOD, fd, &ev) < 0) )
+    { if ( errno == EPERM )		/* e.g., a regular file */
+	rc = PL_domain_error("waitable_stream", A2);
+      else
+	rc = PL_error(NULL, 0, MSG_ERRNO, ERR_SYSCALL, "epoll_ctl");
+      goto out;
+    }
+  }
+  if ( (old=p->entries[fd]) )
+    free_poll_entry(old);
+  p->entries[fd] = e;
+  e = NULL;
+  if ( stream && !poller_check(p, fd) )
+    rc = PL_no_memory();
+
+out:
+  UNLOCK_POLLER(p);
+  if ( e )
+    free_poll_entry(e);
+
+  return rc;
+}
+
+/** poller_delete(+Poller, +Stream)
+ * Remove Stream (or file descriptor) from Poller.  Fails silently if
+ * Stream is not part of Poller.
+ */
+
+static
+PRED_IMPL("poller_delete", 2, poller_delete, 0)
+{ PRED_LD
+  poller *p = NULL;
+  poll_entry *e = NULL;
+  atom_t stream;
+  int fd;
+
+  if ( !get_poller(A1, &p) ||
+       !get_poll_fd(A2, &fd, &stream) )
+    return false;
+
+  LOCK_POLLER(p);
+  if ( fd < p->size && (e=p->entries[fd]) )
+  { p->entries[fd] = NULL;
+    epoll_ctl(p->epfd, EPOLL_CTL_DEL, fd, NULL); /* may be closed */
+  }
+  UNLOCK_POLLER(p);
+
+  if ( e )
+  { free_poll_entry(e);
+    return true;
+  }
+
+  return false;
+}
+
+/* Add the entry for fd to the ready list if we did not do so in
+ * this generation.  Must be called with the poller locked.
+ */
+
+#define poller_ready(p, fd, gen, list, head, tmp) \
+	LDFUNC(poller_ready, p, fd, gen, list, head, tmp)
+
+static int
+poller_ready(DECL_LD poller *p, int fd, unsigned int gen,
+	     term_t list, term_t head, term_t tmp)
+{ poll_entry *e;
+
+  if ( fd < p->size && (e=p->entries[fd]) && e->reported != gen )
+  { e->reported = gen;
+    if ( e->stream && !poller_check(p, fd) )
+      return PL_no_memory();
+    return ( PL_recorded(e->data, tmp) &&
+	     PL_unify_list(list, head, list) &&
+	     PL_unify(head, tmp) );
+  }
+
+  return true;
+}
+
+/* Put the streams of the check list we took back if poller_wait/3 does
+ * not complete.  Streams reported in this generation are already back
+ * on the check list.  Must be called with the poller locked.
+ */
+
+static void
+poller_recheck(poller *p, const int *check, int check_count, unsigned int gen)
+{ int i;
+
+  for(i=0; i<check_count; i++)
+  { int fd = check[i];
+    poll_entry *e;
+
+    if ( fd < p->size && (e=p->entries[fd]) && e->stream &&
+	 e->reported != gen && !poller_check(p, fd) )
+      break;
+  }
+}
+
+/** poller_wait(+Poller, -Ready, +TimeOut)
+ * Wait for input on the streams of Poller and unify Ready with the
+ * Data of the streams that have input.
+ */
+
+static
+PRED_IMPL("poller_wait", 3, poller_wait, 0)
+{ PRED_LD
+  poller *p = NULL;
+  struct epoll_event events[POLLER_MAX_EVENTS];
+  term_t list = PL_copy_term_ref(A2);
+  term_t head = PL_new_term_ref();
+  term_t tmp  = PL_new_term_ref();
+  term_t st   = PL_new_term_ref();
+  int *check = NULL;
+  int check_count;
+  int buffered = 0;
+  unsigned int gen;
+  int i, n, to;
+  int rc = false;
+
+  if ( !get_poller(A1, &p) ||
+       !get_poll_timeout(A3, &to) )
+    return false;
+
+  LOCK_POLLER(p);
+  gen = ++p->generation;
+  check = p->check;			/* take the check list */
+  check_count = p->check_count;
+  p->check = NULL;
+  p->check_count = p->check_size = 0;
+  UNLOCK_POLLER(p);
+
+  for(i=0; i<check_count; i++)		/* check for buffered input */
+  { int fd = check[i];
+    poll_entry *e;
+    atom_t stream = 0;
+    IOSTREAM *s;
+    size_t pending = 0;
+
+    LOCK_POLLER(p);			/* do not lock streams while locked */
+    if ( fd < p->size && (e=p->entries[fd]) && (stream=e->stream) )
+      PL_register_atom(stream);
+    UNLOCK_POLLER(p);
+    if ( !stream )
+      continue;
+
+    if ( PL_put_atom(st, stream) && PL_get_stream(st, &s, SIO_INPUT) )
+    { pending = Spending(s);
+      releaseStream(s);
+    } else				/* closed */
+    { PL_clear_exception();
+    }
+    PL_unregister_atom(stream);
+
+    if ( pending > 0 )
+    { LOCK_POLLER(p);
+      rc = poller_ready(p, fd, gen, list, head, tmp);
+      UNLOCK_POLLER(p);
+      if ( !rc )
+	goto out;
+      buffered++;
+    }
+  }
+  rc = false;
+
+  if ( buffered )
+    to = 0;
+  while( (n=epoll_wait(p->epfd, events, POLLER_MAX_EVENTS, to)) < 0 &&
+	 errno == EINTR )
+  { if ( PL_handle_signals() < 0 )
+      goto out;				/* exception */
+  }
+  if ( n < 0 )
+  { PL_error(NULL, 0, MSG_ERRNO, ERR_SYSCALL, "epoll_wait");
+    goto out;
+  }
+
+  LOCK_POLLER(p);
+  for(i=0; i<n; i++)
+  { if ( !poller_ready(p, events[i].data.fd, gen, list, head, tmp) )
+    { UNLOCK_POLLER(p);
+      goto out;
+    }
+  }
+  UNLOCK_POLLER(p);
+
+  rc = PL_unify_nil(list);
+
+out:
+  if ( !rc && check )
+  { LOCK_POLLER(p);
+    poller_recheck(p, check, check_count, gen);
+    UNLOCK_POLLER(p);
+  }
+  free(check);
+  return rc;
+}
+
+#endif /*HAVE_SYS_EPOLL_H*/
+
+
 		/********************************
 		*      PROLOG CONNECTION        *
 		*********************************/
@@ -2875,18 +3407,22 @@ out:
 
 static void
 re_buffer(IOSTREAM *s, const char *from, size_t len)
-{ if ( s->bufp < s->limitp )
+{ if ( s->bufp < s->limitp )		/* keep pending data */
   { size_t size = s->limitp - s->bufp;
 
-    memmove(s->buffer, s->bufp, size);
-    s->bufp = s->buffer;
-    s->limitp = &s->bufp[size];
+    if ( (size_t)(s->bufp - s->buffer) >= len )
+    { s->bufp -= len;
+    } else
+    { memmove(s->buffer+len, s->bufp, size);
+      s->bufp = s->buffer;
+      s->limitp = &s->bufp[len+size];
+    }
   } else
-  { s->bufp = s->limitp = s->buffer;
+  { s->bufp = s->buffer;
+    s->limitp = s->bufp + len;
   }
 
   memcpy(s->bufp, from, len);
-  s->limitp = s->bufp + len;
 }
 
 
@@ -2998,16 +3534,22 @@ read_pending_input(DECL_LD term_t input, term_t list, term_t tail, int chars)
 	if ( !allocList(n, &ctx) )
 	  goto failure;
 
-	for(i=0; i<n; i++)
-	{ int c = buf[i]&0xff;
+	if ( !memchr(buf, '\r', n) )
+	{ for(i=0; i<n; i++)
+	    ADD_CODE(buf[i]&0xff);
+	  S__fupdatefilepos_span(s, buf, n);
+	} else
+	{ for(i=0; i<n; i++)
+	  { int c = buf[i]&0xff;
 
-	  if ( c == '\r' && skip_cr(s) )
-	    continue;
+	    if ( c == '\r' && skip_cr(s) )
+	      continue;
 
-	  if ( s->position )
-	    S__fupdatefilepos_getc(s, c);
+	    if ( s->position )
+	      S__fupdatefilepos_getc(s, c);
 
-	  ADD_CODE(c);
+	    ADD_CODE(c);
+	  }
 	}
 	if ( s->position )
 	  s->position->byteno = pos0.byteno+n;
@@ -3061,11 +3603,14 @@ read_pending_input(DECL_LD term_t input, term_t list, term_t tail, int chars)
       { const char *us = buf;
 	const char *es = buf+n;
 	size_t count = 0, i;
+	int cr = !!memchr(buf, '\r', n);
 
 	while(us<es)
 	{ if ( !(us[0]&0x80) )
-	  { count++;
-	    us++;
+	  { size_t len = utf8_ascii_span(us, es-us);
+
+	    count += len;
+	    us += len;
 	  } else
 	  { int ex = UTF8_FBN(us[0]);
 
@@ -3093,6 +3638,18 @@ read_pending_input(DECL_LD term_t input, term_t list, term_t tail, int chars)
 	for(us=buf,i=0; i<count; i++)
 	{ int c;
 
+	  if ( !(us[0]&0x80) && !cr )	/* run of ASCII characters */
+	  { size_t len = utf8_ascii_span(us, count-i);
+	    size_t j;
+
+	    for(j=0; j<len; j++)
+	      ADD_CODE(us[j]);
+	    S__fupdatefilepos_span(s, us, len);
+	    us += len;
+	    i += len-1;
+	    continue;
+	  }
+
 	  PL_utf8_code_point(&us, es, &c);
 	  if ( c == '\r' && skip_cr(s) )
 	    continue;
@@ -3265,7 +3822,10 @@ PRED_IMPL("peek_string", 3, peek_string, 0)
 
   if ( getInputStream(A1, S_DONTCARE, &s) )
   { for(;;)
-    { if ( s->limitp > s->bufp )
+    { size_t avail;
+      int eof;
+
+      if ( s->limitp > s->bufp )
       { PL_chars_t text;
 
 	text.text.t    = s->bufp;
@@ -3291,7 +3851,14 @@ PRED_IMPL("peek_string", 3, peek_string, 0)
       if ( s->limitp - s->bufp == s->bufsize )
 	Ssetbuffer(s, NULL, s->bufsize*2);
 
-      if ( S__fillbuf(s) < 0 )
+      avail = s->limitp - s->bufp;
+      eof = (S__fillbuf(s) < 0);
+      if ( !eof )
+      { s->bufp--;
+	eof = ((size_t)(s->limitp - s->bufp) <= avail); /* mapped file */
+      }
+
+      if ( eof )
       { PL_chars_t text;
 	int rc;
 
@@ -3312,7 +3879,6 @@ PRED_IMPL("peek_string", 3, peek_string, 0)
 	releaseStream(s);
 	return rc;
       }
-      s->bufp--;
     }
   }
 
@@ -4012,12 +4578,15 @@ static const PL_option_t open4_options[] =
   { ATOM_eof_action,     OPT_ATOM },
   { ATOM_close_on_abort, OPT_BOOL },
   { ATOM_buffer,	 OPT_ATOM },
+  { ATOM_buffer_size,	 OPT_INT },
   { ATOM_lock,		 OPT_ATOM },
   { ATOM_wait,		 OPT_BOOL },
   { ATOM_encoding,	 OPT_ATOM },
   { ATOM_newline,	 OPT_ATOM },
   { ATOM_bom,		 OPT_BOOL },
   { ATOM_create,	 OPT_TERM },
+  { ATOM_map,		 OPT_BOOL },
+  { ATOM_async,		 OPT_INT },
 #ifdef O_LOCALE
   { ATOM_locale,	 OPT_LOCALE },
 #endif
@@ -4076,6 +4645,7 @@ openStream(term_t file, term_t mode, term_t options)
   atom_t alias		= NULL_ATOM;
   atom_t eof_action     = ATOM_eof_code;
   atom_t buffer         = ATOM_full;
+  int	 buffer_size	= -1;
   atom_t lock		= ATOM_none;
   atom_t newline	= 0;
   unsigned int fnewline = SIO_NL_UNDEF;
@@ -4087,6 +4657,8 @@ openStream(term_t file, term_t mode, term_t options)
   int    close_on_abort = true;
   int	 bom		= -1;
   term_t create		= 0;
+  int	 map		= false;
+  int	 async		= 0;
   char   how[16];
   char  *h		= how;
   char *path;
@@ -4102,10 +4674,17 @@ openStream(term_t file, term_t mode, term_t options)
   if ( options )
   { if ( !PL_scan_options(options, 0, "stream_option", open4_options,
 			  &type, &reposition, &alias, &eof_action,
-			  &close_on_abort, &buffer, &lock, &wait,
-			  &encoding, &newline, &bom, &create
+			  &close_on_abort, &buffer, &buffer_size, &lock, &wait,
+			  &encoding, &newline, &bom, &create, &map, &async
 			  LOCALE_ARG) )
       return false;
+    if ( buffer_size != -1 && buffer_size < 1 )
+    { term_t t;
+
+      if ( (t=PL_new_term_ref()) && PL_put_integer(t, buffer_size) )
+	PL_error(NULL, 0, NULL, ERR_DOMAIN, ATOM_not_less_than_one, t);
+      return NULL;
+    }
   }
 
 					/* MODE */
@@ -4173,6 +4752,15 @@ openStream(term_t file, term_t mode, term_t options)
     bom = (mname == ATOM_read ? true : false);
   if ( type == ATOM_binary )
     *h++ = 'b';
+  if ( map && mname == ATOM_read )
+    *h++ = 'M';
+  if ( async > 0 )
+  { if ( async > 99 )
+      async = 99;
+    *h++ = 'A';
+    *h++ = async/10 + '0';
+    *h++ = async%10 + '0';
+  }
 
 					/* File locking */
   if ( lock != ATOM_none )
@@ -4260,6 +4848,8 @@ openStream(term_t file, term_t mode, term_t options)
 #endif
   if ( !close_on_abort )
     s->flags |= SIO_NOCLOSE;
+  if ( buffer_size > 0 && !(s->flags&SIO_USERBUF) )
+    Ssetbuffer(s, NULL, buffer_size);
 
   if ( how[0] == 'r' )
   { if ( !set_eof_action(s, eof_action) )
@@ -4926,6 +5516,30 @@ stream_tty_prop(DECL_LD IOSTREAM *s, term_t prop)
 }
 
 
+#define stream_async_prop(s, prop) LDFUNC(stream_async_prop, s, prop)
+static int
+stream_async_prop(DECL_LD IOSTREAM *s, term_t prop)
+{ int depth;
+
+  if ( (depth = Sasync_depth(s)) > 0 )
+    return PL_unify_integer(prop, depth);
+
+  return false;
+}
+
+
+#define stream_owned_prop(s, prop) LDFUNC(stream_owned_prop, s, prop)
+static int
+stream_owned_prop(DECL_LD IOSTREAM *s, term_t prop)
+{ IGNORE_LD
+
+  if ( s->owner )
+    return PL_unify_bool_ex(prop, true);
+
+  return false;
+}
+
+
 #define stream_bom_prop(s, prop) LDFUNC(stream_bom_prop, s, prop)
 static int
 stream_bom_prop(DECL_LD IOSTREAM *s, term_t prop)
@@ -5031,7 +5645,7 @@ stream_buffer_size_prop(DECL_LD IOSTREAM *s, term_t prop)
     return false;
 
   if ( (size = s->bufsize) == 0 )
-    size = SIO_BUFSIZE;
+    size = (int)Sdefault_buffer_size(NULL);
 
   return PL_unify_integer(prop, size);
 }
@@ -5120,8 +5734,10 @@ static const sprop sprop_list [] =
   _SP1( FUNCTOR_file_no1,	stream_file_no_prop ),
   _SP1( FUNCTOR_buffer1,	stream_buffer_prop ),
   _SP1( FUNCTOR_buffer_size1,	stream_buffer_size_prop ),
+  _SP1( FUNCTOR_async1,		stream_async_prop ),
   _SP1( FUNCTOR_close_on_abort1,stream_close_on_abort_prop ),
   _SP1( FUNCTOR_tty1,		stream_tty_prop ),
+  _SP1( FUNCTOR_owned1,		stream_owned_prop ),
   _SP1( FUNCTOR_encoding1,	stream_encoding_prop ),
 #ifdef O_LOCALE
   _SP1( FUNCTOR_locale1,	stream_locale_prop ),
@@ -6120,6 +6736,10 @@ PRED_IMPL("$size_stream", 2, size_stream, 0)
 copy_stream_data(+StreamIn, +StreamOut, [Len])
 	Copy all data from StreamIn to StreamOut.  Should be somewhere else,
 	and maybe we need something else to copy resources.
+
+	If both streams are binary file streams, Scopy_fd() lets the
+	kernel copy the data.  If that stops early, e.g., because the
+	kernel cannot copy between these files, we continue below.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 #define copy_stream_data(in, out, len) LDFUNC(copy_stream_data, in, out, len)
@@ -6128,6 +6748,7 @@ copy_stream_data(DECL_LD term_t in, term_t out, term_t len)
 { IOSTREAM *i, *o;
   int c, rc;
   int count = 0;
+  int64_t copied;
 
   if ( !getInputStream(in, S_DONTCARE, &i) )
     return false;
@@ -6137,7 +6758,10 @@ copy_stream_data(DECL_LD term_t in, term_t out, term_t len)
   }
 
   if ( !len )
-  { while ( (c = Sgetcode(i)) != EOF )
+  { if ( Scopy_fd(i, o, -1) < 0 )
+      goto error;
+
+    while ( (c = Sgetcode(i)) != EOF )
     { if ( (++count % 4096) == 0 && PL_handle_signals() < 0 )
       { releaseStream(i);
 	releaseStream(o);
@@ -6152,7 +6776,15 @@ copy_stream_data(DECL_LD term_t in, term_t out, term_t len)
   { int64_t n;
 
     if ( !PL_get_int64_ex(len, &n) )
+    { releaseStream(i);
+      releaseStream(o);
       return false;
+    }
+    if ( n > 0 )
+    { if ( (copied = Scopy_fd(i, o, n)) < 0 )
+	goto error;
+      n -= copied;
+    }
 
     while ( n-- > 0 && (c = Sgetcode(i)) != EOF )
     { if ( (++count % 4096) == 0 && PL_handle_signals() < 0 )
@@ -6169,6 +6801,12 @@ copy_stream_data(DECL_LD term_t in, term_t out, term_t len)
   rc = streamStatus(i) && rc;
 
   return rc;
+
+error:					/* error or exception */
+  streamStatus(o);
+  streamStatus(i);
+
+  return false;
 }
 
 static
@@ -6269,6 +6907,12 @@ BeginPredDefs(file)
   PRED_DEF("seek", 4, seek, 0)
 #ifdef HAVE_PRED_WAIT_FOR_INPUT
   PRED_DEF("wait_for_input", 3, wait_for_input, 0)
+#endif
+#ifdef HAVE_PRED_POLLER
+  PRED_DEF("poller_create", 1, poller_create, 0)
+  PRED_DEF("poller_add", 3, poller_add, 0)
+  PRED_DEF("poller_delete", 2, poller_delete, 0)
+  PRED_DEF("poller_wait", 3, poller_wait, 0)
 #endif
   PRED_DEF("get_single_char", 1, get_single_char, 0)
   PRED_DEF("read_pending_codes", 3, read_pending_codes, 0)
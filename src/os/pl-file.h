@@ -79,6 +79,7 @@ void		unreferenceStandardStreams(PL_local_data_t *ld);
 void		copyStandardStreams(PL_local_data_t *ldnew,
 				    PL_local_data_t *ldold, intptr_t flags);
 void		closeFiles(int all);
+void		releaseOwnedStreams(void);
 int		openFileDescriptors(unsigned char *buf, int size);
 void		protocol(const char *s, size_t n);
 int		getTextInputStream(term_t t, IOSTREAM **s);
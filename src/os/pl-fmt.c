@@ -165,10 +165,8 @@ outstring(format_state *state, const char *s, size_t len)
   { addMultipleBuffer(&state->buffer, s, len, char);
     state->buffered += len;
   } else
-  { for(q=s; q < e; q++)
-    { if ( Sputcode(*q&0xff, state->out) < 0 )
-	return false;
-    }
+  { if ( Sputs_latin1(s, len, state->out) < 0 )
+      return false;
   }
 
   for(q=s; q < e; q++)
@@ -224,12 +222,23 @@ outtext(format_state *state, PL_chars_t *txt)
     { const pl_wchar_t *s = txt->text.w;
       const pl_wchar_t *e = &s[txt->length];
 
-      while(s<e)
-      { int c;
-
-	s = get_wchar(s, &c);
-	if ( !outchr(state, c) )
+      if ( !state->pending_rubber )
+      { if ( Sputs_wchar(s, txt->length, state->out) < 0 )
 	  return false;
+	while(s<e)
+	{ int c;
+
+	  s = get_wchar(s, &c);
+	  update_column(state, c);
+	}
+      } else
+      { while(s<e)
+	{ int c;
+
+	  s = get_wchar(s, &c);
+	  if ( !outchr(state, c) )
+	    return false;
+	}
       }
 
       return true;
@@ -338,7 +347,10 @@ format_impl(IOSTREAM *out, term_t format, term_t Args, Module m)
   term_t args = PL_copy_term_ref(Args);
   int rval;
   PL_chars_t fmt;
+  atom_t a = 0;
 
+  if ( !PL_get_atom(format, &a) )
+    a = 0;
   if ( !PL_get_text(format, &fmt, CVT_ATOM|CVT_STRING|CVT_LIST|BUF_STACK) )
     return PL_error("format", 3, NULL, ERR_TYPE, ATOM_text, format);
 
@@ -366,7 +378,7 @@ format_impl(IOSTREAM *out, term_t format, term_t Args, Module m)
   }
 
   Slock(out);
-  rval = do_format(out, &fmt, argc, argv, m);
+  rval = do_format(out, &fmt, a, argc, argv, m);
   Sunlock(out);
   PL_free_text(&fmt);
 
@@ -481,16 +493,226 @@ end_sub_format(sub_state *state, int rc)
 
 
 
+		/********************************
+		*       FORMAT PROGRAMS		*
+		********************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A format text is first translated into a format_program, an array of
+directives that describes the runs of literal text and the ~ directives
+with their parsed numeric argument, `*` and colon modifier. Programs for
+formats that are atoms are kept in a small per-thread cache that is
+indexed by the atom handle, such that calling format/2,3 repeatedly with
+the same atom does not parse the format again.
+
+The cache does not reference the atom. Instead, each cached program has
+a copy of the format text and a hit is only accepted if the text
+matches. This allows AGC to reclaim the atom, after which the entry is
+simply replaced when its slot is reused. A program is removed from the
+cache while it is being executed as the format may call Prolog, which
+may call format/2,3 again.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define FMT_LITERAL	(-1)		/* literal text */
+#define FMT_SYNTAX	(-2)		/* syntax error in directive */
+
+typedef struct fmt_directive
+{ int		code;			/* directive character or FMT_* */
+  int		arg;			/* numeric argument or DEFAULT */
+  bool		star;			/* argument is `*` */
+  bool		colon;			/* used colon modifier */
+  size_t	start;			/* FMT_LITERAL: start index */
+  size_t	length;			/* FMT_LITERAL: #chars */
+  const char   *message;		/* FMT_SYNTAX: error message */
+} fmt_directive;
+
+typedef struct format_program
+{ atom_t	atom;			/* cached for this atom (or 0) */
+  IOENC		encoding;		/* encoding of text */
+  size_t	length;			/* length of text in chars */
+  char	       *text;			/* copy of the text */
+  size_t	count;			/* # directives */
+  fmt_directive	directives[1];		/* the directives */
+} format_program;
+
+static inline int
+fmt_chr(const PL_chars_t *fmt, size_t index)
+{ return index < fmt->length ? get_chr_from_text(fmt, (int)index) : 0;
+}
+
+static size_t
+text_bytes(const PL_chars_t *fmt)
+{ return fmt->encoding == ENC_WCHAR ? fmt->length*sizeof(pl_wchar_t)
+				    : fmt->length;
+}
+
+static format_program *
+compile_format(const PL_chars_t *fmt, atom_t a)
+{ tmp_buffer b;
+  size_t here = 0;
+  size_t count, tlen;
+  format_program *prog;
+
+  initBuffer(&b);
+  while(here < fmt->length)
+  { fmt_directive d = { .arg = DEFAULT };
+    size_t start = here;
+    bool neg = false;
+    int c;
+
+    while(here < fmt->length && get_chr_from_text(fmt, (int)here) != '~')
+      here++;
+    if ( here > start )
+    { d.code   = FMT_LITERAL;
+      d.start  = start;
+      d.length = here-start;
+      addBuffer(&b, d, fmt_directive);
+      continue;
+    }
+					/* Get the numeric argument */
+    c = fmt_chr(fmt, ++here);
+    if ( c == '-' )
+    { neg = true;
+      c = fmt_chr(fmt, ++here);
+      if ( !isDigitW(c) )
+      { d.code = FMT_SYNTAX;
+	d.message = "invalid argument";
+	addBuffer(&b, d, fmt_directive);
+	break;
+      }
+    }
+
+    if ( isDigitW(c) )
+    { int arg = c - '0';
+
+      here++;
+      while(here < fmt->length)
+      { c = get_chr_from_text(fmt, (int)here);
+
+	if ( isDigitW(c) )
+	{ int dw = c - '0';
+	  int arg2 = arg*10 + dw;
+
+	  if ( (arg2 - dw)/10 != arg )	/* see mul64() in pl-arith.c */
+	  { d.code = FMT_SYNTAX;
+	    d.message = "argument overflow";
+	    break;
+	  }
+	  arg = arg2;
+	  here++;
+	} else
+	{ if ( neg )
+	    arg = -arg;
+	  break;
+	}
+      }
+      if ( d.code == FMT_SYNTAX )
+      { addBuffer(&b, d, fmt_directive);
+	break;
+      }
+      d.arg = arg;
+    } else if ( c == '*' )
+    { d.star = true;
+      c = fmt_chr(fmt, ++here);
+    } else if ( c == '`' )
+    { d.arg = fmt_chr(fmt, ++here);
+      c = fmt_chr(fmt, ++here);
+    }
+
+    if ( c == ':' )
+    { d.colon = true;
+      c = fmt_chr(fmt, ++here);
+    }
+
+    d.code = c;
+    addBuffer(&b, d, fmt_directive);
+    here++;
+  }
+
+  count = entriesBuffer(&b, fmt_directive);
+  tlen  = a ? text_bytes(fmt) : 0;
+  prog  = malloc(offsetof(format_program, directives) +
+		 (count ? count : 1)*sizeof(fmt_directive) + tlen);
+  if ( prog )
+  { prog->atom     = a;
+    prog->encoding = fmt->encoding;
+    prog->length   = fmt->length;
+    prog->count    = count;
+    memcpy(prog->directives, baseBuffer(&b, fmt_directive),
+	   count*sizeof(fmt_directive));
+    prog->text = (char*)&prog->directives[count ? count : 1];
+    if ( tlen )
+      memcpy(prog->text, fmt->text.t, tlen);
+  } else
+  { PL_no_memory();
+  }
+  discardBuffer(&b);
+
+  return prog;
+}
+
+#define format_cache_slot(a) LDFUNC(format_cache_slot, a)
+static inline format_program **
+format_cache_slot(DECL_LD atom_t a)
+{ return &LD->format.cache[indexAtom(a)%FORMAT_CACHE_SIZE];
+}
+
+#define get_format_program(fmt, a) LDFUNC(get_format_program, fmt, a)
+static format_program *
+get_format_program(DECL_LD const PL_chars_t *fmt, atom_t a)
+{ if ( a )
+  { format_program **slot = format_cache_slot(a);
+    format_program *prog = *slot;
+
+    if ( prog && prog->atom == a &&
+	 prog->encoding == fmt->encoding &&
+	 prog->length == fmt->length &&
+	 memcmp(prog->text, fmt->text.t, text_bytes(fmt)) == 0 )
+    { *slot = NULL;
+      return prog;
+    }
+  }
+
+  return compile_format(fmt, a);
+}
+
+#define release_format_program(prog) LDFUNC(release_format_program, prog)
+static void
+release_format_program(DECL_LD format_program *prog)
+{ if ( prog->atom )
+  { format_program **slot = format_cache_slot(prog->atom);
+
+    if ( *slot )
+      free(*slot);
+    *slot = prog;
+  } else
+  { free(prog);
+  }
+}
+
+void
+freeFormatCache(PL_local_data_t *ld)
+{ for(int i=0; i<FORMAT_CACHE_SIZE; i++)
+  { if ( ld->format.cache[i] )
+    { free(ld->format.cache[i]);
+      ld->format.cache[i] = NULL;
+    }
+  }
+}
+
+
 		/********************************
 		*       ACTUAL FORMATTING	*
 		********************************/
 
-bool
-do_format(IOSTREAM *fd, PL_chars_t *fmt, int argc, term_t argv, Module m)
+static bool
+run_format(IOSTREAM *fd, PL_chars_t *fmt, const format_program *prog,
+	   int argc, term_t argv, Module m)
 { GET_LD
   format_state state;			/* complete state */
   int tab_stop = 0;			/* padded tab stop */
-  unsigned int here = 0;
+  const fmt_directive *d = prog->directives;
+  const fmt_directive *de = d + prog->count;
   int rc = true;
 
   state.out = fd;
@@ -503,468 +725,413 @@ do_format(IOSTREAM *fd, PL_chars_t *fmt, int argc, term_t argv, Module m)
   else
     state.column = 0;
 
-  while(here < fmt->length)
-  { int c = get_chr_from_text(fmt, here);
-
-    switch(c)
-    { case '~':
-	{ int arg = DEFAULT;		/* Numeric argument */
-	  int mod_colon = false;	/* Used colon modifier */
-	  bool neg = false;
-	  predicate_t proc;
-					/* Get the numeric argument */
-	  c = get_chr_from_text(fmt, ++here);
-	  if ( c == '-' )
-	  { neg = true;
-	    c = get_chr_from_text(fmt, ++here);
-	    if ( !isDigitW(c) )
-	    { FMT_ERROR("invalid argument");
-	    }
+  for(; d < de; d++)
+  { int c = d->code;
+    int arg = d->arg;			/* Numeric argument */
+    int mod_colon = d->colon;		/* Used colon modifier */
+    predicate_t proc;
+
+    if ( c == FMT_LITERAL )
+    { PL_chars_t txt = *fmt;
+
+      if ( txt.encoding == ENC_WCHAR )
+	txt.text.w += d->start;
+      else
+	txt.text.t += d->start;
+      txt.length = d->length;
+      if ( !(rc=outtext(&state, &txt)) )
+	goto out;
+      continue;
+    }
+    if ( c == FMT_SYNTAX )
+      FMT_ERROR(d->message);
+    if ( d->star )
+    { NEED_ARG;
+      if ( PL_get_integer(argv, &arg) && arg >= 0 )
+      { SHIFT;
+      } else
+	FMT_ERROR("no or negative integer for `*' argument");
+    }
+
+					/* Check for user defined format */
+    if ( format_predicates &&
+	 (proc = lookupHTableWP(format_predicates, c)) )
+    { size_t arity;
+      term_t av;
+      sub_state sstate;
+      int i;
+
+      PL_predicate_info(proc, NULL, &arity, NULL);
+      av = PL_new_term_refs((int)arity);
+
+      if ( arg == DEFAULT )
+	PL_put_atom(av+0, ATOM_default);
+      else
+	PL_put_integer(av+0, arg);
+
+      for(i=1; i < arity; i++)
+      { NEED_ARG;
+	PL_put_term(av+i, argv);
+	SHIFT;
+      }
+
+      if ( !(rc=prepare_sub_format(&sstate, &state, fd)) )
+	goto out;
+      rc = PL_call_predicate(NULL, PL_Q_PASS_EXCEPTION, proc, av);
+      rc = end_sub_format(&sstate, rc);
+
+      if ( !rc )
+	goto out;
+    } else
+    { switch(c)			/* Build in formatting */
+      { case 'a':			/* atomic */
+	  { PL_chars_t txt;
+
+	    NEED_ARG;
+	    if ( !PL_get_text(argv, &txt, CVT_ATOMIC) )
+	      FMT_ARG("a", argv);
+	    SHIFT;
+	    rc = outtext(&state, &txt);
+	    if ( !rc )
+	      goto out;
+	    break;
 	  }
+	case 'c':			/* ~c: character code */
+	  { int chr;
 
-	  if ( isDigitW(c) )
-	  { arg = c - '0';
+	    NEED_ARG;
+	    if ( PL_get_integer(argv, &chr) && chr >= 0 )
+	    { int times = (arg == DEFAULT ? 1 : arg);
 
-	    here++;
-	    while(here < fmt->length)
-	    { c = get_chr_from_text(fmt, here);
+	      SHIFT;
+	      while(times-- > 0)
+	      { rc = outchr(&state, chr);
+		if ( !rc )
+		  goto out;
+	      }
+	    } else
+	      FMT_ARG("c", argv);
+	    break;
+	  }
+	case 'e':			/* exponential float */
+	case 'E':			/* Exponential float */
+	case 'f':			/* float */
+	case 'g':			/* shortest of 'f' and 'e' */
+	case 'G':			/* shortest of 'f' and 'E' */
+	case 'h':
+	case 'H':			/* Precise */
+	  { number n;
+	    union
+	    { tmp_buffer b;
+	      buffer b1;
+	    } u;
+	    PL_locale *l;
+	    AR_CTX
+
+	    NEED_ARG;
+	    AR_BEGIN();
+	    if ( !PL_get_number(argv, &n) )
+	    { if ( !valueExpression(argv, &n) )
+	      { char f[2];
+
+		f[0] = (char)c;
+		f[1] = EOS;
+		AR_CLEANUP();
+		FMT_ARG(f, argv); /* returns error */
+	      }
+	    }
+	    SHIFT;
 
-	      if ( isDigitW(c) )
-	      { int dw = c - '0';
-		int arg2 = arg*10 + dw;
+	    if ( c == 'f' && mod_colon )
+	      l = fd->locale;
+	    else
+	      l = &prolog_locale;
+
+	    initBuffer(&u.b);
+	    rc = formatFloat(l, c, arg, &n, &u.b1) != NULL;
+	    clearNumber(&n);
+	    AR_END();
+	    if ( rc )
+	      rc = oututf80(&state, baseBuffer(&u.b, char));
+	    discardBuffer(&u.b);
+	    if ( !rc )
+	      goto out;
+	    break;
+	  }
+	case 'd':			/* integer */
+	case 'D':			/* grouped integer */
+	case 'r':			/* radix number */
+	case 'R':			/* Radix number */
+	case 'I':			/* Prolog 1_000_000 */
+	  { number i;
+	    tmp_buffer b;
+	    char *si;
+	    AR_CTX
+
+	    NEED_ARG;
+	    AR_BEGIN();
+	    if ( !PL_get_number(argv, &i) )
+	    { if ( !valueExpression(argv, &i) )
+	      { AR_CLEANUP();
+		FMT_ARGC(c, argv); /* return with error */
+	      }
+	    }
+	    if ( !isIntegerNumber(&i) )
+	    { if ( !toIntegerNumber(&i, 0) )
+	      { AR_CLEANUP();
+		FMT_ARGC(c, argv);
+	      }
+	    }
 
-		if ( (arg2 - dw)/10 != arg )	/* see mul64() in pl-arith.c */
-		{ FMT_ERROR("argument overflow");
+	    SHIFT;
+	    initBuffer(&b);
+	    if ( c == 'd' || c == 'D' )
+	    { PL_locale ltmp;
+	      PL_locale *l;
+	      static char grouping[] = {3,0};
+
+	      if ( c == 'D' )
+	      { if ( mod_colon )
+		{ ltmp.thousands_sep = L"_";
+		  ltmp.decimal_point = L".";
+		  ltmp.grouping = grouping;
+		} else
+		{ ltmp.thousands_sep = L",";
+		  ltmp.decimal_point = L".";
+		  ltmp.grouping = grouping;
 		}
-		arg = arg2;
-		here++;
+		l = &ltmp;
+	      } else if ( mod_colon )
+	      { l = fd->locale;
 	      } else
-	      { if ( neg )
-		  arg = -arg;
-		break;
+	      { l = NULL;
 	      }
+
+	      if ( arg == DEFAULT )
+		arg = 0;
+	      si = formatInteger(l, arg, 10, true, &i, (Buffer)&b);
+	    } else if ( c == 'I' )
+	    { PL_locale ltmp;
+	      char grouping[2];
+
+	      grouping[0] = (char)(arg == DEFAULT ? 3 : arg);
+	      grouping[1] = '\0';
+	      ltmp.thousands_sep = L"_";
+	      ltmp.grouping = grouping;
+
+	      si = formatInteger(&ltmp, 0, 10, true, &i, (Buffer)&b);
+	    } else			/* r,R */
+	    { if ( arg == DEFAULT )
+		arg = 8;
+	      if ( arg < 2 || arg > 36 )
+	      { term_t r = PL_new_term_ref();
+
+		PL_put_integer(r, arg);
+		PL_error(NULL, 0, NULL, ERR_DOMAIN, ATOM_radix, r);
+		si = NULL;
+	      } else
+		si = formatInteger(NULL, 0, arg, c == 'r', &i, (Buffer)&b);
+	    }
+	    clearNumber(&i);
+	    AR_END();
+	    if ( si )
+	      rc = oututf80(&state, si);
+	    else
+	      rc = false;
+	    discardBuffer(&b);
+	    if ( !rc )
+	      goto out;
+	    break;
+	  }
+	case 's':			/* string */
+	  { PL_chars_t txt;
+
+	    NEED_ARG;
+	    if ( !PL_get_text(argv, &txt, CVT_ATOM|CVT_LIST|CVT_STRING) )
+	      FMT_ARG("s", argv);
+	    if ( arg != DEFAULT )
+	    { if ( arg < 0 )
+		arg = 0;
+	      if ( arg < txt.length )
+		txt.length = arg;
 	    }
-	  } else if ( c == '*' )
+	    rc = outtext(&state, &txt);
+	    PL_free_text(&txt);
+	    SHIFT;
+	    if ( !rc )
+	      goto out;
+	    break;
+	  }
+	case 'i':			/* ignore */
 	  { NEED_ARG;
-	    if ( PL_get_integer(argv, &arg) && arg >= 0 )
-	    { SHIFT;
-	    } else
-	      FMT_ERROR("no or negative integer for `*' argument");
-	    c = get_chr_from_text(fmt, ++here);
-	  } else if ( c == '`' && here < fmt->length )
-	  { arg = get_chr_from_text(fmt, ++here);
-	    c = get_chr_from_text(fmt, ++here);
+	    SHIFT;
+	    break;
 	  }
+	  { Func1 f;
+	    sub_state sstate;
 
-	  if ( c == ':' )
-	  { mod_colon = true;
-	    c = get_chr_from_text(fmt, ++here);
-	  }
+	case 'k':			/* write_canonical */
+	    f = pl_write_canonical;
+	    goto pl_common;
+	case 'p':			/* print */
+	    f = pl_print;
+	    goto pl_common;
+	case 'q':			/* writeq */
+	    f = pl_writeq;
+	    goto pl_common;
+	case 'w':			/* write */
+	    f = pl_write;
+	    pl_common:
+
+	    NEED_ARG;
 
-					/* Check for user defined format */
-	  if ( format_predicates &&
-	       (proc = lookupHTableWP(format_predicates, c)) )
-	  { size_t arity;
-	    term_t av;
-	    sub_state sstate;
-	    int i;
+	    if ( !(rc=prepare_sub_format(&sstate, &state, fd)) )
+	      goto out;
+	    rc = (int)(*f)(argv);
+	    rc = end_sub_format(&sstate, rc);
 
-	    PL_predicate_info(proc, NULL, &arity, NULL);
-	    av = PL_new_term_refs((int)arity);
+	    if ( !rc )
+	     goto out;
 
-	    if ( arg == DEFAULT )
-	      PL_put_atom(av+0, ATOM_default);
-	    else
-	      PL_put_integer(av+0, arg);
+	    SHIFT;
+	    break;
+	  }
+	case 'W':			/* write_term(Value, Options) */
+	 { sub_state sstate;
+
+	   if ( argc < 2 )
+	   { FMT_ERROR("not enough arguments");
+	   }
+
+	   if ( !(rc=prepare_sub_format(&sstate, &state, fd)) )
+	     goto out;
+	   rc = (int)pl_write_term(argv, argv+1);
+	   rc = end_sub_format(&sstate, rc);
+
+	   if ( !rc )
+	     goto out;
+
+	   SHIFT;
+	   SHIFT;
+	   break;
+	 }
+	case '@':
+	  { term_t ex = 0;
+	    sub_state sstate;
+	    fid_t fid;
 
-	    for(i=1; i < arity; i++)
-	    { NEED_ARG;
-	      PL_put_term(av+i, argv);
-	      SHIFT;
+	    if ( argc < 1 )
+	    { FMT_ERROR("not enough arguments");
 	    }
 
 	    if ( !(rc=prepare_sub_format(&sstate, &state, fd)) )
 	      goto out;
-	    rc = PL_call_predicate(NULL, PL_Q_PASS_EXCEPTION, proc, av);
+
+	    rc = ( (fid=PL_open_foreign_frame()) &&
+		   callProlog(m, argv, PL_Q_CATCH_EXCEPTION, &ex) );
+	    if ( rc )
+	      PL_rewind_foreign_frame(fid);
 	    rc = end_sub_format(&sstate, rc);
 
 	    if ( !rc )
+	    { if ( ex && !PL_exception(0) )
+		rc = PL_raise_exception(ex);
 	      goto out;
+	    }
 
-	    here++;
-	  } else
-	  { switch(c)			/* Build in formatting */
-	    { case 'a':			/* atomic */
-		{ PL_chars_t txt;
-
-		  NEED_ARG;
-		  if ( !PL_get_text(argv, &txt, CVT_ATOMIC) )
-		    FMT_ARG("a", argv);
-		  SHIFT;
-		  rc = outtext(&state, &txt);
-		  if ( !rc )
-		    goto out;
-		  here++;
-		  break;
-		}
-	      case 'c':			/* ~c: character code */
-		{ int chr;
-
-		  NEED_ARG;
-		  if ( PL_get_integer(argv, &chr) && chr >= 0 )
-		  { int times = (arg == DEFAULT ? 1 : arg);
-
-		    SHIFT;
-		    while(times-- > 0)
-		    { rc = outchr(&state, chr);
-		      if ( !rc )
-			goto out;
-		    }
-		  } else
-		    FMT_ARG("c", argv);
-		  here++;
-		  break;
-		}
-	      case 'e':			/* exponential float */
-	      case 'E':			/* Exponential float */
-	      case 'f':			/* float */
-	      case 'g':			/* shortest of 'f' and 'e' */
-	      case 'G':			/* shortest of 'f' and 'E' */
-	      case 'h':
-	      case 'H':			/* Precise */
-		{ number n;
-		  union
-		  { tmp_buffer b;
-		    buffer b1;
-		  } u;
-		  PL_locale *l;
-		  AR_CTX
-
-		  NEED_ARG;
-		  AR_BEGIN();
-		  if ( !PL_get_number(argv, &n) )
-		  { if ( !valueExpression(argv, &n) )
-		    { char f[2];
-
-		      f[0] = (char)c;
-		      f[1] = EOS;
-		      AR_CLEANUP();
-		      FMT_ARG(f, argv); /* returns error */
-		    }
-		  }
-		  SHIFT;
-
-		  if ( c == 'f' && mod_colon )
-		    l = fd->locale;
-		  else
-		    l = &prolog_locale;
-
-		  initBuffer(&u.b);
-		  rc = formatFloat(l, c, arg, &n, &u.b1) != NULL;
-		  clearNumber(&n);
-		  AR_END();
-		  if ( rc )
-		    rc = oututf80(&state, baseBuffer(&u.b, char));
-		  discardBuffer(&u.b);
-		  if ( !rc )
-		    goto out;
-		  here++;
-		  break;
-		}
-	      case 'd':			/* integer */
-	      case 'D':			/* grouped integer */
-	      case 'r':			/* radix number */
-	      case 'R':			/* Radix number */
-	      case 'I':			/* Prolog 1_000_000 */
-		{ number i;
-		  tmp_buffer b;
-		  char *si;
-		  AR_CTX
-
-		  NEED_ARG;
-		  AR_BEGIN();
-		  if ( !PL_get_number(argv, &i) )
-		  { if ( !valueExpression(argv, &i) )
-		    { AR_CLEANUP();
-		      FMT_ARGC(c, argv); /* return with error */
-		    }
-		  }
-		  if ( !isIntegerNumber(&i) )
-		  { if ( !toIntegerNumber(&i, 0) )
-		    { AR_CLEANUP();
-		      FMT_ARGC(c, argv);
-		    }
-		  }
-
-		  SHIFT;
-		  initBuffer(&b);
-		  if ( c == 'd' || c == 'D' )
-		  { PL_locale ltmp;
-		    PL_locale *l;
-		    static char grouping[] = {3,0};
-
-		    if ( c == 'D' )
-		    { if ( mod_colon )
-		      { ltmp.thousands_sep = L"_";
-			ltmp.decimal_point = L".";
-			ltmp.grouping = grouping;
-		      } else
-		      { ltmp.thousands_sep = L",";
-			ltmp.decimal_point = L".";
-			ltmp.grouping = grouping;
-		      }
-		      l = &ltmp;
-		    } else if ( mod_colon )
-		    { l = fd->locale;
-		    } else
-		    { l = NULL;
-		    }
-
-		    if ( arg == DEFAULT )
-		      arg = 0;
-		    si = formatInteger(l, arg, 10, true, &i, (Buffer)&b);
-		  } else if ( c == 'I' )
-		  { PL_locale ltmp;
-		    char grouping[2];
-
-		    grouping[0] = (char)(arg == DEFAULT ? 3 : arg);
-		    grouping[1] = '\0';
-		    ltmp.thousands_sep = L"_";
-		    ltmp.grouping = grouping;
-
-		    si = formatInteger(&ltmp, 0, 10, true, &i, (Buffer)&b);
-		  } else			/* r,R */
-		  { if ( arg == DEFAULT )
-		      arg = 8;
-		    if ( arg < 2 || arg > 36 )
-		    { term_t r = PL_new_term_ref();
-
-		      PL_put_integer(r, arg);
-		      PL_error(NULL, 0, NULL, ERR_DOMAIN, ATOM_radix, r);
-		      si = NULL;
-		    } else
-		      si = formatInteger(NULL, 0, arg, c == 'r', &i, (Buffer)&b);
-		  }
-		  clearNumber(&i);
-		  AR_END();
-		  if ( si )
-		    rc = oututf80(&state, si);
-		  else
-		    rc = false;
-		  discardBuffer(&b);
-		  if ( !rc )
-		    goto out;
-		  here++;
-		  break;
-		}
-	      case 's':			/* string */
-		{ PL_chars_t txt;
-
-		  NEED_ARG;
-		  if ( !PL_get_text(argv, &txt, CVT_ATOM|CVT_LIST|CVT_STRING) )
-		    FMT_ARG("s", argv);
-		  if ( arg != DEFAULT )
-		  { if ( arg < 0 )
-		      arg = 0;
-		    if ( arg < txt.length )
-		      txt.length = arg;
-		  }
-		  rc = outtext(&state, &txt);
-		  PL_free_text(&txt);
-		  SHIFT;
-		  if ( !rc )
-		    goto out;
-		  here++;
-		  break;
-		}
-	      case 'i':			/* ignore */
-		{ NEED_ARG;
-		  SHIFT;
-		  here++;
-		  break;
-		}
-		{ Func1 f;
-		  sub_state sstate;
-
-	      case 'k':			/* write_canonical */
-		  f = pl_write_canonical;
-		  goto pl_common;
-	      case 'p':			/* print */
-		  f = pl_print;
-		  goto pl_common;
-	      case 'q':			/* writeq */
-		  f = pl_writeq;
-		  goto pl_common;
-	      case 'w':			/* write */
-		  f = pl_write;
-		  pl_common:
-
-		  NEED_ARG;
-
-		  if ( !(rc=prepare_sub_format(&sstate, &state, fd)) )
-		    goto out;
-		  rc = (int)(*f)(argv);
-		  rc = end_sub_format(&sstate, rc);
-
-		  if ( !rc )
-		   goto out;
-
-		  SHIFT;
-		  here++;
-		  break;
-		}
-	      case 'W':			/* write_term(Value, Options) */
-	       { sub_state sstate;
-
-		 if ( argc < 2 )
-		 { FMT_ERROR("not enough arguments");
-		 }
-
-		 if ( !(rc=prepare_sub_format(&sstate, &state, fd)) )
-		   goto out;
-		 rc = (int)pl_write_term(argv, argv+1);
-		 rc = end_sub_format(&sstate, rc);
-
-		 if ( !rc )
-		   goto out;
-
-		 SHIFT;
-		 SHIFT;
-		 here++;
-		 break;
-	       }
-	      case '@':
-		{ term_t ex = 0;
-		  sub_state sstate;
-		  fid_t fid;
-
-		  if ( argc < 1 )
-		  { FMT_ERROR("not enough arguments");
-		  }
-
-		  if ( !(rc=prepare_sub_format(&sstate, &state, fd)) )
-		    goto out;
-
-		  rc = ( (fid=PL_open_foreign_frame()) &&
-			 callProlog(m, argv, PL_Q_CATCH_EXCEPTION, &ex) );
-		  if ( rc )
-		    PL_rewind_foreign_frame(fid);
-		  rc = end_sub_format(&sstate, rc);
-
-		  if ( !rc )
-		  { if ( ex && !PL_exception(0) )
-		      rc = PL_raise_exception(ex);
-		    goto out;
-		  }
-
-		  SHIFT;
-		  here++;
-		  break;
-		}
-	      case '~':			/* ~ */
-		{ rc = outchr(&state, '~');
-		  if ( !rc )
-		    goto out;
-		  here++;
-		  break;
-		}
-	      case 'n':			/* \n */
-	      case 'N':			/* \n if not on newline */
-		{ if ( arg == DEFAULT )
-		    arg = 1;
-		  if ( c == 'N' && state.column == 0 )
-		    arg--;
-		  while( arg-- > 0 )
-		  { rc = outchr(&state, '\n');
-		    if ( !rc )
-		      goto out;
-		  }
-		  here++;
-		  break;
-		}
-	      case 't':			/* insert tab */
-		{ if ( state.pending_rubber >= MAXRUBBER )
-		    FMT_ERROR("Too many tab stops");
-
-		  state.rub[state.pending_rubber].where = state.buffered;
-		  state.rub[state.pending_rubber].pad   =
-					(arg == DEFAULT ? (pl_wchar_t)' '
-							: (pl_wchar_t)arg);
-		  state.rub[state.pending_rubber].size = 0;
-		  state.pending_rubber++;
-		  here++;
-		  break;
-		}
-	      case '|':			/* set tab */
-		{ int stop;
-		  int nl_and_reindent;
-
-		  if ( arg == DEFAULT )
-		    arg = state.column;
-		  /*FALLTHROUGH*/
-	      case '+':			/* tab relative */
-		  if ( arg == DEFAULT )
-		    arg = 8;
-		  stop = (c == '+' ? tab_stop + arg : arg);
-
-		  if ( stop < state.column && mod_colon )
-		    nl_and_reindent = state.pending_rubber ?
-						state.rub[state.pending_rubber-1].pad : ' ';
-		  else
-		    nl_and_reindent = 0;
-
-		  if ( state.pending_rubber == 0 ) /* nothing to distribute */
-		  { state.rub[0].where = state.buffered;
-		    state.rub[0].pad = ' ';
-		    state.pending_rubber++;
-		  }
-		  distribute_rubber(state.rub,
-				    state.pending_rubber,
-				    stop - state.column);
-		  if ( !(rc=emit_rubber(&state)) )
-		    goto out;
-
-		  if ( nl_and_reindent )
-		  { if ( Sputcode('\n', state.out) < 0 )
-		    { rc = false;
-		      goto out;
-		    }
-		    update_column(&state, '\n');
-
-		    state.rub[0].where = state.buffered;
-		    state.rub[0].pad = nl_and_reindent;
-		    state.pending_rubber++;
-
-		    distribute_rubber(state.rub,
-				      state.pending_rubber,
-				      stop - state.column);
-		    if ( !(rc=emit_rubber(&state)) )
-		      goto out;
-		  }
-
-		  state.column = tab_stop = stop;
-		  here++;
-		  break;
-		}
-	      default:
-	      { term_t ex = PL_new_term_ref();
+	    SHIFT;
+	    break;
+	  }
+	case '~':			/* ~ */
+	  { rc = outchr(&state, '~');
+	    if ( !rc )
+	      goto out;
+	    break;
+	  }
+	case 'n':			/* \n */
+	case 'N':			/* \n if not on newline */
+	  { if ( arg == DEFAULT )
+	      arg = 1;
+	    if ( c == 'N' && state.column == 0 )
+	      arg--;
+	    while( arg-- > 0 )
+	    { rc = outchr(&state, '\n');
+	      if ( !rc )
+		goto out;
+	    }
+	    break;
+	  }
+	case 't':			/* insert tab */
+	  { if ( state.pending_rubber >= MAXRUBBER )
+	      FMT_ERROR("Too many tab stops");
+
+	    state.rub[state.pending_rubber].where = state.buffered;
+	    state.rub[state.pending_rubber].pad   =
+				  (arg == DEFAULT ? (pl_wchar_t)' '
+						  : (pl_wchar_t)arg);
+	    state.rub[state.pending_rubber].size = 0;
+	    state.pending_rubber++;
+	    break;
+	  }
+	case '|':			/* set tab */
+	  { int stop;
+	    int nl_and_reindent;
+
+	    if ( arg == DEFAULT )
+	      arg = state.column;
+	    /*FALLTHROUGH*/
+	case '+':			/* tab relative */
+	    if ( arg == DEFAULT )
+	      arg = 8;
+	    stop = (c == '+' ? tab_stop + arg : arg);
+
+	    if ( stop < state.column && mod_colon )
+	      nl_and_reindent = state.pending_rubber ?
+					  state.rub[state.pending_rubber-1].pad : ' ';
+	    else
+	      nl_and_reindent = 0;
 
-		PL_put_atom(ex, codeToAtom(c));
-		return PL_error("format", 2, NULL, ERR_EXISTENCE,
-				PL_new_atom("format_character"),
-				ex);
+	    if ( state.pending_rubber == 0 ) /* nothing to distribute */
+	    { state.rub[0].where = state.buffered;
+	      state.rub[0].pad = ' ';
+	      state.pending_rubber++;
+	    }
+	    distribute_rubber(state.rub,
+			      state.pending_rubber,
+			      stop - state.column);
+	    if ( !(rc=emit_rubber(&state)) )
+	      goto out;
+
+	    if ( nl_and_reindent )
+	    { if ( Sputcode('\n', state.out) < 0 )
+	      { rc = false;
+		goto out;
 	      }
+	      update_column(&state, '\n');
+
+	      state.rub[0].where = state.buffered;
+	      state.rub[0].pad = nl_and_reindent;
+	      state.pending_rubber++;
+
+	      distribute_rubber(state.rub,
+				state.pending_rubber,
+				stop - state.column);
+	      if ( !(rc=emit_rubber(&state)) )
+		goto out;
 	    }
+
+	    state.column = tab_stop = stop;
+	    break;
 	  }
-	  break;			/* the '~' switch */
-	}
-      default:
-	{ rc = outchr(&state, c);
-	  if ( !rc )
-	    goto out;
-	  here++;
-	  break;
+	default:
+	{ term_t ex = PL_new_term_ref();
+
+	  PL_put_atom(ex, codeToAtom(c));
+	  return PL_error("format", 2, NULL, ERR_EXISTENCE,
+			  PL_new_atom("format_character"),
+			  ex);
 	}
+      }
     }
   }
 
@@ -976,6 +1143,23 @@ do_format(IOSTREAM *fd, PL_chars_t *fmt, int argc, term_t argv, Module m)
     FMT_ERROR("too many arguments");
 
 out:
+  discardBuffer(&state.buffer);
+  return rc;
+}
+
+
+bool
+do_format(IOSTREAM *fd, PL_chars_t *fmt, atom_t a,
+	  int argc, term_t argv, Module m)
+{ GET_LD
+  format_program *prog;
+  bool rc;
+
+  if ( !(prog = get_format_program(fmt, a)) )
+    return false;
+  rc = run_format(fd, fmt, prog, argc, argv, m);
+  release_format_program(prog);
+
   return rc;
 }
 
@@ -39,7 +39,8 @@
 
 COMMON(char *)	formatInteger(PL_locale *locale, int div, int radix,
 			      bool smll, Number n, Buffer out);
-COMMON(bool)	do_format(IOSTREAM *fd, PL_chars_t *fmt,
+COMMON(bool)	do_format(IOSTREAM *fd, PL_chars_t *fmt, atom_t a,
 			  int argc, term_t argv, Module m);
+COMMON(void)	freeFormatCache(PL_local_data_t *ld);
 
 #endif /*FMT_H_INCLUDED*/
@@ -1219,6 +1219,19 @@ set_prolog_flag_unlocked(DECL_LD Module m, atom_t k, term_t value, unsigned shor
       { if ( i < 0 || i > UINT_MAX )
 	  return PL_representation_error("uint"),NULL;
 	LD->fli.string_buffers.tripwire = (unsigned int)i;
+      } else if ( k == ATOM_stream_buffer_size ||
+		  k == ATOM_stream_buffer_max )
+      { size_t max;
+	size_t size = Sdefault_buffer_size(&max);
+
+	if ( i < (k == ATOM_stream_buffer_size ? 1 : 0) || i > INT_MAX )
+	  return PL_error(NULL, 0, NULL, ERR_DOMAIN,
+			  ATOM_buffer_size, value),NULL;
+	if ( k == ATOM_stream_buffer_size )
+	  size = (size_t)i;
+	else
+	  max = (size_t)i;
+	Sset_default_buffer_size(size, max);
       } else if ( k == ATOM_heartbeat )
       { if ( i < 0 )
 	  return PL_error(NULL, 0, NULL, ERR_DOMAIN,
@@ -1905,6 +1918,8 @@ initPrologFlags(void)
   setPrologFlag("shared_table_space", FT_INTEGER, (intptr_t)GD->options.sharedTableSpace);
 #endif
   setPrologFlag("stack_limit", FT_INTEGER, (intptr_t)LD->stacks.limit);
+  setPrologFlag("stream_buffer_size", FT_INTEGER, (intptr_t)SIO_BUFSIZE);
+  setPrologFlag("stream_buffer_max", FT_INTEGER, (intptr_t)SIO_BUFMAX);
 #ifdef O_DYNAMIC_EXTENSIONS
   setPrologFlag("open_shared_object",	     FT_BOOL|FF_READONLY, true, 0);
   setPrologFlag("shared_object_extension",   FT_ATOM|FF_READONLY, SO_EXT);
@@ -100,6 +100,9 @@ locking is required.
 #include <stdarg.h>
 #include <ctype.h>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 #if defined(HAVE_POLL_H)
 #include <poll.h>
 #elif defined(HAVE_SYS_SELECT_H)
@@ -139,19 +142,29 @@ static int	S__fileno(IOSTREAM *s);
 
 static IOSTREAM *	Sopen_buffer(IOSTREAM *s, char *buf, size_t size);
 static void		Sclose_buffer(IOSTREAM *s);
+static int		S__memfile_is_direct(IOSTREAM *s);
+static int		S__is_mapped(IOSTREAM *s);
+static ssize_t		S__flush_memfile(IOSTREAM *s);
+
+extern int			PL_thread_self(void);
 
 #ifdef O_PLMT
-#define SLOCK(s)    if ( s->mutex ) recursiveMutexLock(s->mutex)
-#define SUNLOCK(s)  if ( s->mutex ) recursiveMutexUnlock(s->mutex)
+/* A stream owned by a thread (see Sset_owner()) is only accessed by that
+   thread and thus does not need the mutex.
+*/
+#define S__owned(s) ((s)->owner && (s)->owner == PL_thread_self())
+#define SLOCK(s)    if ( s->mutex && !S__owned(s) ) recursiveMutexLock(s->mutex)
+#define SUNLOCK(s)  if ( s->mutex && !S__owned(s) ) recursiveMutexUnlock(s->mutex)
 static inline int
 STRYLOCK(IOSTREAM *s)
-{ if ( s->mutex &&
+{ if ( s->mutex && !S__owned(s) &&
        recursiveMutexTryLock(s->mutex) == EBUSY )
     return false;
 
   return true;
 }
 #else
+#define S__owned(s) (true)
 #define SLOCK(s)
 #define SUNLOCK(s)
 #define STRYLOCK(s) (true)
@@ -166,7 +179,301 @@ extern int			PL_handle_signals();
 extern IOENC			initEncoding(void);
 extern bool			reportStreamError(IOSTREAM *s);
 extern record_t			PL_record(term_t t);
-extern int			PL_thread_self(void);
+
+static size_t S__bufsize = SIO_BUFSIZE;	/* default buffer size */
+static size_t S__bufmax  = SIO_BUFMAX;	/* default adaptive limit */
+
+		 /*******************************
+		 *	      POOLING		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Applications that create many  short-lived  streams   (string  and memory
+streams, pipes) spend a  considerable  amount  of   time  in  malloc()
+and free() for the IOSTREAM  structure,  its   mutex  and  its buffer.
+Each thread therefore keeps  a  small  free   list  of  released stream
+structures (with their mutex memory) and  default  size  buffers.  The
+lists are freed when the thread terminates.
+
+Streams that are closed from Prolog are only  released if the stream
+blob is garbage collected, which typically   happens  in the gc thread.
+If the pool of the releasing thread is  full, the object is added to a
+shared pool that is used if the pool   of  the allocating thread is
+empty.  Sstream_pool_statistics() reports how often  an allocation was
+served from one of the pools.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define SIO_POOL_SIZE	     16		/* max cached objects per thread */
+#define SIO_SHARED_POOL_SIZE 64	/* max cached objects in shared pool */
+
+typedef struct pool_buffer
+{ struct pool_buffer *next;		/* next free buffer */
+  size_t	size;			/* bufsize of this buffer */
+} pool_buffer;
+
+typedef struct io_pool
+{ IOSTREAM     *streams;		/* free streams, linked by ->handle */
+  pool_buffer  *buffers;		/* free buffers */
+  int		nstreams;		/* # streams in pool */
+  int		nbuffers;		/* # buffers in pool */
+} io_pool;
+
+static io_pool S__shared_pool;		/* pool shared by all threads */
+static size_t  S__pool_hits;		/* allocations from a pool */
+static size_t  S__pool_misses;		/* allocations using malloc() */
+
+static void
+S__free_pool(void *closure)
+{ io_pool *p = closure;
+  IOSTREAM *s;
+  pool_buffer *b;
+
+  if ( !p )
+    return;
+
+  while( (s=p->streams) )
+  { p->streams = s->handle;
+#ifdef O_PLMT
+    if ( s->mutex )
+      PL_free(s->mutex);
+#endif
+    PL_free(s);
+  }
+  while( (b=p->buffers) )
+  { p->buffers = b->next;
+    free(b);
+  }
+  p->nstreams = p->nbuffers = 0;
+}
+
+#ifdef O_PLMT
+static pthread_key_t   S__pool_key;
+static pthread_once_t  S__pool_once  = PTHREAD_ONCE_INIT;
+static pthread_mutex_t S__pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define LOCK_POOL()   pthread_mutex_lock(&S__pool_mutex)
+#define UNLOCK_POOL() pthread_mutex_unlock(&S__pool_mutex)
+
+/* Other thread-specific destructors may still close streams after the
+   pool was destroyed.  The key is then set to S__POOL_DEAD, so we do not
+   create a new pool that is never freed.
+*/
+
+#define S__POOL_DEAD ((io_pool*)&S__pool_key)
+
+static void
+S__free_thread_pool(void *closure)
+{ if ( closure != S__POOL_DEAD )
+  { S__free_pool(closure);
+    free(closure);
+  }
+  pthread_setspecific(S__pool_key, S__POOL_DEAD);
+}
+
+static void
+S__init_pool_key(void)
+{ pthread_key_create(&S__pool_key, S__free_thread_pool);
+}
+
+static io_pool *
+S__thread_pool(int create)
+{ io_pool *p;
+
+  pthread_once(&S__pool_once, S__init_pool_key);
+  if ( !(p=pthread_getspecific(S__pool_key)) )
+  { if ( create && (p=calloc(1, sizeof(*p))) )
+      pthread_setspecific(S__pool_key, p);
+  } else if ( p == S__POOL_DEAD )
+  { p = NULL;
+  }
+
+  return p;
+}
+#else
+static io_pool S__the_pool;
+#define S__thread_pool(create) (&S__the_pool)
+#define LOCK_POOL()
+#define UNLOCK_POOL()
+#endif
+
+#define S__pool() S__thread_pool(true)
+
+static IOSTREAM *
+pool_get_stream(io_pool *p)
+{ IOSTREAM *s;
+
+  if ( (s=p->streams) )
+  { p->streams = s->handle;
+    p->nstreams--;
+  }
+
+  return s;
+}
+
+static int
+pool_put_stream(io_pool *p, IOSTREAM *s, int max)
+{ if ( p->nstreams < max )
+  { s->magic   = 0;
+    s->handle  = p->streams;
+    p->streams = s;
+    p->nstreams++;
+    return true;
+  }
+
+  return false;
+}
+
+static char *
+pool_get_buffer(io_pool *p, size_t size)
+{ pool_buffer *b, **bp;
+
+  for(bp = &p->buffers; (b=*bp); bp = &b->next)
+  { if ( b->size == size )
+    { *bp = b->next;
+      p->nbuffers--;
+      return (char*)b;
+    }
+  }
+
+  return NULL;
+}
+
+static int
+pool_put_buffer(io_pool *p, char *buf, size_t size, int max)
+{ if ( p->nbuffers < max )
+  { pool_buffer *b = (pool_buffer*)buf;
+
+    b->size    = size;
+    b->next    = p->buffers;
+    p->buffers = b;
+    p->nbuffers++;
+    return true;
+  }
+
+  return false;
+}
+
+/* Allocate a cleared IOSTREAM structure.  If `mutex` is true, the
+   stream gets an initialised mutex.
+*/
+
+static IOSTREAM *
+S__alloc_stream(int mutex)
+{ io_pool *p = S__pool();
+  IOSTREAM *s = NULL;
+  void *m = NULL;
+
+  if ( p )
+    s = pool_get_stream(p);
+  if ( !s && S__shared_pool.nstreams > 0 )
+  { LOCK_POOL();
+    s = pool_get_stream(&S__shared_pool);
+    UNLOCK_POOL();
+  }
+
+  if ( s )
+  { m = s->mutex;
+    ATOMIC_INC(&S__pool_hits);
+  } else
+  { if ( !(s = PL_malloc_uncollectable(sizeof(IOSTREAM))) )
+      return NULL;
+    ATOMIC_INC(&S__pool_misses);
+  }
+
+  memset((char *)s, 0, sizeof(IOSTREAM));
+#ifdef O_PLMT
+  if ( mutex )
+  { if ( !m && !(m = PL_malloc(sizeof(recursiveMutex))) )
+    { PL_free(s);
+      return NULL;
+    }
+    s->mutex = m;
+    recursiveMutexInit(s->mutex);
+  } else if ( m )
+  { PL_free(m);
+  }
+#else
+  (void)mutex;
+  (void)m;
+#endif
+
+  return s;
+}
+
+/* Release a stream structure.  The mutex must be deleted, but its
+   memory is kept with the structure.
+*/
+
+static void
+S__free_stream(IOSTREAM *s)
+{ io_pool *p = S__pool();
+  int done;
+
+  if ( p && pool_put_stream(p, s, SIO_POOL_SIZE) )
+    return;
+
+  LOCK_POOL();
+  done = pool_put_stream(&S__shared_pool, s, SIO_SHARED_POOL_SIZE);
+  UNLOCK_POOL();
+
+  if ( !done )
+  {
+#ifdef O_PLMT
+    if ( s->mutex )
+      PL_free(s->mutex);
+#endif
+    PL_free(s);
+  }
+}
+
+static char *
+S__alloc_buffer(size_t size)
+{ io_pool *p = S__pool();
+  char *buf = NULL;
+
+  if ( p )
+    buf = pool_get_buffer(p, size);
+  if ( !buf && S__shared_pool.nbuffers > 0 )
+  { LOCK_POOL();
+    buf = pool_get_buffer(&S__shared_pool, size);
+    UNLOCK_POOL();
+  }
+
+  if ( buf )
+  { ATOMIC_INC(&S__pool_hits);
+    return buf;
+  }
+
+  ATOMIC_INC(&S__pool_misses);
+  return malloc(size+UNDO_SIZE);
+}
+
+/* Release a buffer.  Only buffers of the default size are pooled.
+*/
+
+static void
+S__free_buffer(char *buf, size_t size)
+{ io_pool *p = S__pool();
+  int done = false;
+
+  if ( size == S__bufsize )
+  { if ( p && pool_put_buffer(p, buf, size, SIO_POOL_SIZE) )
+      return;
+
+    LOCK_POOL();
+    done = pool_put_buffer(&S__shared_pool, buf, size, SIO_SHARED_POOL_SIZE);
+    UNLOCK_POOL();
+  }
+
+  if ( !done )
+    free(buf);
+}
+
+void
+Sstream_pool_statistics(size_t *hits, size_t *misses)
+{ *hits   = S__pool_hits;
+  *misses = S__pool_misses;
+}
 
 
 		 /*******************************
@@ -187,7 +494,7 @@ S__setbuf(IOSTREAM *s, char *buffer, size_t size)
   int newflags = s->flags;
 
   if ( size == 0 )
-    size = SIO_BUFSIZE;
+    size = S__bufsize;
 
   if ( (s->flags & SIO_OUTPUT) )
   { if ( S__removebuf(s) < 0 )
@@ -198,7 +505,7 @@ S__setbuf(IOSTREAM *s, char *buffer, size_t size)
   { newunbuf = newbuf = buffer;
     newflags |= SIO_USERBUF;
   } else
-  { if ( !(newunbuf = malloc(size+UNDO_SIZE)) )
+  { if ( !(newunbuf = S__alloc_buffer(size)) )
     { errno = ENOMEM;
       S__seterror(s);
       return -1;
@@ -228,7 +535,7 @@ S__setbuf(IOSTREAM *s, char *buffer, size_t size)
       { if ( !(newflags & SIO_USERBUF) )
 	{ int oldeno = errno;
 
-	  free(newunbuf);
+	  S__free_buffer(newunbuf, size);
 	  errno = oldeno;
 	  S__seterror(s);
 	  return -1;
@@ -258,6 +565,65 @@ void
 Ssetbuffer(IOSTREAM *s, char *buffer, size_t size)
 { if ( S__setbuf(s, buffer, size) != (size_t)-1 )
     s->flags &= ~SIO_USERBUF;
+  s->bufmax = 0;			/* explicit size: do not adapt */
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Adaptive buffering. A fully buffered stream that keeps filling or flushing
+its entire buffer doubles the buffer  size  until  it  reaches `bufmax`.
+This is only enabled for regular  files   opened  using Sopen_file().
+Pipes and sockets are often interactive, where  a larger output buffer
+delays data the other side is waiting for.
+This reduces the number of system  calls   for  bulk  transfers  without
+wasting memory on streams that are used for small amounts of data.  The
+defaults for new streams are set using Sset_default_buffer_size(), which
+is used for the Prolog flags `stream_buffer_size` and `stream_buffer_max`.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+void
+Sset_default_buffer_size(size_t size, size_t max)
+{ S__bufsize = size;
+  S__bufmax  = max;
+}
+
+
+size_t
+Sdefault_buffer_size(size_t *max)
+{ if ( max )
+    *max = S__bufmax;
+  return S__bufsize;
+}
+
+
+#define S__can_grow(s) \
+	( (s)->bufmax > (s)->bufsize && \
+	  ((s)->flags&(SIO_FBUF|SIO_USERBUF|SIO_ISATTY)) == SIO_FBUF )
+
+static void
+S__growbuf(IOSTREAM *s)
+{ size_t size = (size_t)s->bufsize*2;
+  size_t bufp = s->bufp - s->unbuffer;
+  size_t limitp = s->limitp - s->unbuffer;
+  char *newunbuf;
+
+  if ( size > (size_t)s->bufmax )
+    size = s->bufmax;
+
+  if ( (newunbuf = malloc(size+UNDO_SIZE)) )
+  { memcpy(newunbuf, s->unbuffer, (s->flags&SIO_OUTPUT) ? bufp : limitp);
+    S__free_buffer(s->unbuffer, s->bufsize);
+    s->unbuffer = newunbuf;
+    s->buffer   = newunbuf + UNDO_SIZE;
+    s->bufp     = newunbuf + bufp;
+    s->bufsize  = (int)size;
+    if ( (s->flags & SIO_OUTPUT) )
+      s->limitp = &s->buffer[size];
+    else
+      s->limitp = newunbuf + limitp;
+  } else
+  { s->bufmax = 0;			/* no memory; stop trying */
+  }
 }
 
 
@@ -270,7 +636,7 @@ S__removebuf(IOSTREAM *s)
       rval = -1;
 
     if ( !(s->flags & SIO_USERBUF) )
-      free(s->unbuffer);
+      S__free_buffer(s->unbuffer, s->bufsize);
     s->bufp = s->limitp = s->buffer = s->unbuffer = NULL;
     s->bufsize = 0;
 
@@ -321,6 +687,11 @@ S__lock(IOSTREAM *s)
   { SUNLOCK(s);
     return -1;
   }
+  if ( s->owner && !S__owned(s) )	/* checked after getting the mutex */
+  { SUNLOCK(s);
+    errno = EPERM;
+    return -1;
+  }
 
   if ( s->locks == 0 )
   { if ( (s->flags & (SIO_NBUF|SIO_OUTPUT)) == (SIO_NBUF|SIO_OUTPUT) &&
@@ -384,6 +755,49 @@ Sunlock(IOSTREAM *s)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Sset_owner(IOSTREAM *s, int own) makes the  calling thread the exclusive
+owner of the stream or gives up  ownership.   While  a stream is owned,
+locking it from the owner only  checks   the  owner and skips the mutex,
+while Slock() and Sclose() from any other thread fail with EPERM. The
+stream may not be locked by the caller when changing the ownership.
+Returns 0 on success and -1 (with errno set) otherwise. Streams owned
+using set_stream/2 are released when the owning thread terminates;
+C code must release the streams it owns itself.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+int
+Sset_owner(IOSTREAM *s, int own)
+{
+#ifdef O_PLMT
+  int self = PL_thread_self();
+  int rc = 0;
+
+  if ( own && s->owner == self )
+    return 0;
+  if ( self <= 0 || (s->owner && s->owner != self) )
+  { errno = EPERM;
+    return -1;
+  }
+
+  if ( s->mutex )
+    recursiveMutexLock(s->mutex);
+  if ( s->locks > 0 )
+  { errno = EBUSY;
+    rc = -1;
+  } else
+  { s->owner = own ? self : 0;
+  }
+  if ( s->mutex )
+    recursiveMutexUnlock(s->mutex);
+
+  return rc;
+#else
+  return 0;
+#endif
+}
+
+
 IOSTREAM *
 Sacquire(IOSTREAM *s)
 { Sreference(s);
@@ -521,6 +935,8 @@ S__flushbuf(IOSTREAM *s)
   { errno = EINVAL;
     return -1;
   }
+  if ( (s->flags&SIO_USERBUF) && S__memfile_is_direct(s) )
+    return S__flush_memfile(s);
   SLOCK(s);
   from = s->buffer;
   to   = s->bufp;
@@ -583,9 +999,12 @@ static int
 S__flushbufc(int c, IOSTREAM *s)
 { if ( s->buffer )
   { if ( S__flushbuf(s) <= 0 )		/* == 0: no progress!? */
-      c = -1;
-    else
+    { c = -1;
+    } else
+    { if ( s->bufp == s->buffer && S__can_grow(s) )
+	S__growbuf(s);
       *s->bufp++ = (char)c;
+    }
   } else
   { if ( s->flags & SIO_NBUF )
     { char chr = (char)c;
@@ -675,8 +1094,8 @@ S__fillbuf(IOSTREAM *s)
       len = s->bufsize;
     } else if ( s->bufp < s->limitp )
     { len = s->limitp - s->bufp;
-      if ( len == s->bufsize )
-      { c = char_to_int(*s->bufp++);
+      if ( len == s->bufsize || S__is_mapped(s) )
+      { c = char_to_int(*s->bufp++);	/* full or no more data */
 	return c;
       }
       memmove(s->buffer, s->bufp, s->limitp - s->bufp);
@@ -684,7 +1103,9 @@ S__fillbuf(IOSTREAM *s)
       s->limitp = &s->bufp[len];
       len = s->bufsize - len;
     } else
-    { s->bufp = s->limitp = s->buffer;
+    { if ( s->limitp == s->buffer+s->bufsize && S__can_grow(s) )
+	S__growbuf(s);			/* last read filled the buffer */
+      s->bufp = s->limitp = s->buffer;
       len = s->bufsize;
     }
 
@@ -1314,6 +1735,7 @@ Speekcode(IOSTREAM *s)
 { int c;
   char *start;
   size_t safe = (size_t)-1;
+  intptr_t bufmax;
 
   if ( !s->buffer )
   { if ( (s->flags & SIO_NBUF) )
@@ -1333,6 +1755,8 @@ Speekcode(IOSTREAM *s)
   }
 
   start = s->bufp;
+  bufmax = s->bufmax;			/* growing would invalidate start */
+  s->bufmax = 0;
   if ( s->position )
   { IOPOS *psave = s->position;
     s->position = NULL;
@@ -1341,6 +1765,7 @@ Speekcode(IOSTREAM *s)
   } else
   { c = Sgetcode(s);
   }
+  s->bufmax = bufmax;
   if ( Sferror(s) )
     return -1;
 
@@ -1358,70 +1783,309 @@ Speekcode(IOSTREAM *s)
 
 
 		 /*******************************
-		 *	    PUTW/GETW		*
+		 *	   BULK TEXT I/O	*
 		 *******************************/
 
-int
-Sputw(int w, IOSTREAM *s)
-{ unsigned char *q = (unsigned char *)&w;
-  unsigned int n;
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+The routines below  transfer  runs   of  single-byte  characters between
+the stream buffer and the  caller   without  encoding  or decoding every
+character through Sgetcode()/Sputcode(). They only handle the buffer at
+hand and the  cases  where  a  byte  is  the  character  (ASCII  in an
+ASCII-compatible encoding) and return 0 or stop  early if the next byte
+needs the general code path.  Position information is updated once for
+the whole run.
+
+S__fupdatefilepos_span() updates the position for `len` single-byte
+characters. Note that update_linepos() only needs to be applied to the
+characters after the last newline.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-  for(n=0; n<sizeof(w); n++)
-  { if ( Sputc(*q++, s) < 0 )
-      return -1;
-  }
+void
+S__fupdatefilepos_span(IOSTREAM *s, const char *q, size_t len)
+{ IOPOS *p = s->position;
+  const char *e = q+len;
+  const char *nl;
 
-  return w;
-}
+  if ( !p )
+    return;
 
+  p->byteno += len;
+  p->charno += len;
+  if ( (nl=memchr(q, '\n', len)) )
+  { do
+    { p->lineno++;
+      q = nl+1;
+    } while( (nl=memchr(q, '\n', e-q)) );
+    p->linepos = 0;
+    s->flags &= ~SIO_NOLINEPOS;
+  }
 
-int
-Sgetw(IOSTREAM *s)
-{ int w;
-  unsigned char *q = (unsigned char *)&w;
-  unsigned int n;
+  for(; q<e; q++)
+    update_linepos(s, *q&0xff);
+}
 
-  for(n=0; n<sizeof(w); n++)
-  { int c;
 
-    if ( (c = Sgetc(s)) < 0 )
-      return -1;
-    *q++ = (unsigned char)c;
+static inline int
+S__byte_is_char(IOSTREAM *s)
+{ switch(s->encoding)
+  { case ENC_OCTET:
+    case ENC_ISO_LATIN_1:
+    case ENC_ASCII:
+    case ENC_UTF8:
+      return !s->tee;
+    default:
+      return false;
   }
-
-  return w;
 }
 
-		 /*******************************
-		 *	    FREAD/FWRITE	*
-		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Sfetch_ascii() returns the longest run  of   at  most  `max` ASCII bytes
+from the buffer of the input stream  `s`   that  does not contain a byte
+`c` for which stop[c] is non-zero. `stop` may  be NULL. The run starts
+at `*start` and is consumed from the stream.  Returns 0 if the buffer is
+empty or the next character  must  be   read  using  Sgetcode(). Carriage
+returns are left to Sgetcode() if they may need to be deleted.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 size_t
-Sfread(void *data, size_t size, size_t elms, IOSTREAM *s)
-{ size_t chars = size * elms;
-  char *buf = data;
+Sfetch_ascii(IOSTREAM *s, const char *stop, size_t max, const char **start)
+{ const char *q = s->bufp;
+  const char *e;
+  size_t len;
 
-  if ( s->position )
-  { for( ; chars > 0; chars-- )
-    { int c;
+  if ( q >= s->limitp || !S__byte_is_char(s) )
+    return 0;
 
-      if ( (c = Sgetc(s)) == EOF )
-	break;
+  len = s->limitp - q;
+  if ( len > max )
+    len = max;
 
-      *buf++ = (char)c;
+  if ( stop || ((s->flags&SIO_TEXT) && s->newline != SIO_NL_POSIX) )
+  { int cr = ((s->flags&SIO_TEXT) && s->newline != SIO_NL_POSIX);
+
+    for(e = q+len; q<e; q++)		/* do not scan beyond the stop */
+    { unsigned char c = *q;
+
+      if ( (c&0x80) || (stop && stop[c]) || (cr && c == '\r') )
+	break;
     }
+    len = q - s->bufp;
   } else
-  { while(chars > 0)
-    { int c;
+  { len = utf8_ascii_span(q, len);
+  }
 
-      if ( s->bufp < s->limitp )
-      { size_t avail = s->limitp - s->bufp;
+  if ( len > 0 )
+  { *start = s->bufp;
+    s->bufp += len;
+    S__fupdatefilepos_span(s, *start, len);
+  }
 
-	if ( chars <= avail )
-	{ memcpy(buf, s->bufp, chars);
-	  s->bufp += chars;
-	  return elms;
-	} else
+  return len;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Sfetch_ascii_to() is  the  same  as   Sfetch_ascii(),  but  stops at the
+single ASCII character `sep`. This is used for reading lines and records
+and locates `sep` using memchr() rather than a stop table.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+size_t
+Sfetch_ascii_to(IOSTREAM *s, int sep, size_t max, const char **start)
+{ const char *q = s->bufp;
+  int cr = ((s->flags&SIO_TEXT) && s->newline != SIO_NL_POSIX);
+  size_t avail, len = 0;
+
+  if ( q >= s->limitp || !S__byte_is_char(s) )
+    return 0;
+
+  avail = s->limitp - q;
+  if ( avail > max )
+    avail = max;
+
+  while( len < avail )			/* scan in chunks to avoid scanning */
+  { size_t chunk = avail-len;		/* far beyond a non-ASCII byte */
+    const char *e;
+    int found = false;
+    size_t n;
+
+    if ( chunk > 256 )
+      chunk = 256;
+    if ( (e = memchr(q+len, sep, chunk)) )
+    { chunk = e-(q+len);
+      found = true;
+    }
+    if ( cr && (e = memchr(q+len, '\r', chunk)) )
+    { chunk = e-(q+len);
+      found = true;
+    }
+    n = utf8_ascii_span(q+len, chunk);
+    len += n;
+    if ( n < chunk || found )
+      break;
+  }
+
+  if ( len > 0 )
+  { *start = q;
+    s->bufp += len;
+    S__fupdatefilepos_span(s, q, len);
+  }
+
+  return len;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Sputs_latin1() writes `len` ISO Latin-1  characters   to  `s`. Runs of
+ASCII characters are copied  into  the   buffer  at  once;  other
+characters and newlines that require special handling are written using
+Sputcode(). Returns 0 on success and -1 on error.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+int
+Sputs_latin1(const char *q, size_t len, IOSTREAM *s)
+{ const char *e = q+len;
+  int nl = ( (s->flags&SIO_LBUF) ||
+	     ((s->flags&SIO_TEXT) && s->newline == SIO_NL_DOS) );
+
+  while(q < e)
+  { if ( s->bufp < s->limitp && S__byte_is_char(s) )
+    { size_t n = s->limitp - s->bufp;
+
+      if ( n > (size_t)(e-q) )
+	n = e-q;
+      if ( s->encoding != ENC_OCTET && s->encoding != ENC_ISO_LATIN_1 )
+	n = utf8_ascii_span(q, n);
+      if ( nl )
+      { const char *p = memchr(q, '\n', n);
+
+	if ( p )
+	  n = p-q;
+      }
+
+      if ( n > 0 )
+      { memcpy(s->bufp, q, n);
+	s->bufp += n;
+	s->lastc = q[n-1]&0xff;
+	S__fupdatefilepos_span(s, q, n);
+	q += n;
+	continue;
+      }
+    }
+
+    if ( Sputcode(*q++&0xff, s) < 0 )
+      return -1;
+  }
+
+  return 0;
+}
+
+
+/* Sputs_wchar() is the wide character version of Sputs_latin1()
+*/
+
+int
+Sputs_wchar(const wchar_t *q, size_t len, IOSTREAM *s)
+{ const wchar_t *e = q+len;
+  int nl = ( (s->flags&SIO_LBUF) ||
+	     ((s->flags&SIO_TEXT) && s->newline == SIO_NL_DOS) );
+
+  while(q < e)
+  { int c;
+
+    if ( s->bufp < s->limitp && S__byte_is_char(s) )
+    { char *o = s->bufp;
+      char *oe = s->limitp;
+      const wchar_t *f = q;
+
+      if ( oe-o > e-q )
+	oe = o+(e-q);
+      while( o < oe && (unsigned)*q < 0x80 && !(nl && *q == '\n') )
+	*o++ = (char)*q++;
+
+      if ( q > f )
+      { s->lastc = o[-1]&0xff;
+	S__fupdatefilepos_span(s, s->bufp, o-s->bufp);
+	s->bufp = o;
+	continue;
+      }
+    }
+
+    q = get_wchar(q, &c);
+    if ( Sputcode(c, s) < 0 )
+      return -1;
+  }
+
+  return 0;
+}
+
+
+		 /*******************************
+		 *	    PUTW/GETW		*
+		 *******************************/
+
+int
+Sputw(int w, IOSTREAM *s)
+{ unsigned char *q = (unsigned char *)&w;
+  unsigned int n;
+
+  for(n=0; n<sizeof(w); n++)
+  { if ( Sputc(*q++, s) < 0 )
+      return -1;
+  }
+
+  return w;
+}
+
+
+int
+Sgetw(IOSTREAM *s)
+{ int w;
+  unsigned char *q = (unsigned char *)&w;
+  unsigned int n;
+
+  for(n=0; n<sizeof(w); n++)
+  { int c;
+
+    if ( (c = Sgetc(s)) < 0 )
+      return -1;
+    *q++ = (unsigned char)c;
+  }
+
+  return w;
+}
+
+		 /*******************************
+		 *	    FREAD/FWRITE	*
+		 *******************************/
+
+size_t
+Sfread(void *data, size_t size, size_t elms, IOSTREAM *s)
+{ size_t chars = size * elms;
+  char *buf = data;
+
+  if ( s->position )
+  { for( ; chars > 0; chars-- )
+    { int c;
+
+      if ( (c = Sgetc(s)) == EOF )
+	break;
+
+      *buf++ = (char)c;
+    }
+  } else
+  { while(chars > 0)
+    { int c;
+
+      if ( s->bufp < s->limitp )
+      { size_t avail = s->limitp - s->bufp;
+
+	if ( chars <= avail )
+	{ memcpy(buf, s->bufp, chars);
+	  s->bufp += chars;
+	  return elms;
+	} else
 	{ memcpy(buf, s->bufp, avail);
 	  chars -= avail;
 	  buf += avail;
@@ -1575,6 +2239,8 @@ ScheckBOM(IOSTREAM *s)
       return 0;				/* empty stream */
     }
     s->bufp--;
+    if ( (size_t)(s->limitp - s->bufp) <= avail )
+      return 0;				/* no more data (mapped file) */
   }
 }
 
@@ -2028,8 +2694,10 @@ unallocStream(IOSTREAM *s)
 #ifdef O_PLMT
   if ( s->mutex )
   { recursiveMutexDelete(s->mutex);
-    PL_free(s->mutex);
-    s->mutex = NULL;
+    if ( (s->flags & SIO_STATIC) )
+    { PL_free(s->mutex);
+      s->mutex = NULL;
+    }
   }
 #endif
 
@@ -2042,7 +2710,7 @@ unallocStream(IOSTREAM *s)
   }
 
   if ( !(s->flags & SIO_STATIC) )
-    PL_free(s);
+    S__free_stream(s);			/* keeps the mutex memory */
 }
 
 
@@ -2087,6 +2755,12 @@ S__close(IOSTREAM *s, int flags)
   } else
     SLOCK(s);
 
+  if ( s->owner && !S__owned(s) && !(flags&SIO_CLOSE_FORCE) )
+  { SUNLOCK(s);				/* the owner does not lock */
+    s->io_errno = errno = EPERM;
+    return -1;
+  }
+
   s->flags |= SIO_CLOSING;
   rval = S__removebuf(s);
   if ( s->mbstate )
@@ -2194,10 +2868,8 @@ Sgets(char *buf)
 
 int
 Sfputs(const char *q, IOSTREAM *s)
-{ for( ; *q; q++)
-  { if ( Sputcode(*q&0xff, s) < 0 )
-      return EOF;
-  }
+{ if ( Sputs_latin1(q, strlen(q), s) < 0 )
+    return EOF;
 
   return 0;
 }
@@ -3254,130 +3926,968 @@ IOFUNCTIONS Sfilefunctions =
 
 
 		 /*******************************
-		 *	    TTY STREAMS		*
+		 *	   KERNEL COPY		*
 		 *******************************/
 
-static ssize_t
-Sread_tty(void *handle, char *buf, size_t size)
-{ ssize_t bytes = Sread_file(handle, buf, size);
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Scopy_fd(in, out, len) copies up to  len   bytes  (all  if len < 0) from
+`in` to `out` without passing the data   through user space if both are
+binary file streams.  Data  buffered  in  `in`   is  copied  first and
+`out` is flushed.  We try copy_file_range(),  sendfile() and splice(),
+using the first that manages to move data.
+
+Returns the number of bytes copied or -1 if writing the buffered data or
+flushing `out` failed or a signal handler raised an exception.  If the
+kernel refuses, this  is  not  an  error:   the  caller  must  copy the
+remaining data the normal way, which also reports I/O errors properly.
+As after Sseek64(), line number information is no longer maintained.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-  if ( bytes < 0 && errno == EBADF )
-  { errno = 0;
-    return 0;
-  }
+#define KC_CHUNK (4*1024*1024)		/* Check signals after each chunk */
 
-  return bytes;
-}
+typedef enum
+{ KC_COPY_FILE_RANGE = 0,
+  KC_SENDFILE,
+  KC_SPLICE,
+  KC_NONE
+} kc_method;
 
+static int
+Sbinary_fd(IOSTREAM *s)
+{ if ( s->functions != &Sfilefunctions ||
+       s->encoding != ENC_OCTET ||
+       ((s->flags&SIO_TEXT) && s->newline != SIO_NL_POSIX) ||
+       s->timeout >= 0 || s->tee )
+    return -1;
 
-static ssize_t
-Swrite_tty(void *handle, char *buf, size_t size)
-{ ssize_t bytes = Swrite_file(handle, buf, size);
+  return (int)(intptr_t)s->handle;
+}
 
-  if ( bytes == -1 && errno == EBADF )
-  { errno = 0;
-    return size;
+static ssize_t
+kernel_copy(kc_method method, int fdin, int fdout, size_t size)
+{ switch(method)
+  {
+#ifdef HAVE_COPY_FILE_RANGE
+    case KC_COPY_FILE_RANGE:
+      return copy_file_range(fdin, NULL, fdout, NULL, size, 0);
+#endif
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+    case KC_SENDFILE:
+      return sendfile(fdout, fdin, NULL, size);
+#endif
+#ifdef HAVE_SPLICE
+    case KC_SPLICE:
+      return splice(fdin, NULL, fdout, NULL, size, SPLICE_F_MOVE);
+#endif
+    default:
+      errno = ENOSYS;
+      return -1;
   }
+}
 
-  return bytes;
+static void
+skip_position(IOSTREAM *s, int64_t bytes)
+{ if ( s->position )
+  { s->flags |= (SIO_NOLINENO|SIO_NOLINEPOS);
+    s->position->byteno += bytes;
+    s->position->charno += bytes;
+  }
 }
 
+int64_t
+Scopy_fd(IOSTREAM *in, IOSTREAM *out, int64_t len)
+{ int fdin, fdout;
+  kc_method method = KC_COPY_FILE_RANGE;
+  int moved = false;			/* method moved data */
+  int64_t done = 0;
+
+  if ( (fdin=Sbinary_fd(in)) < 0 || (fdout=Sbinary_fd(out)) < 0 ||
+       !(in->flags & SIO_INPUT) || (in->flags & (SIO_FEOF|SIO_FERR)) )
+    return 0;
 
-static int
-Sclose_tty(void *handle)
-{ int rc = Sclose_file(handle);
+  while( in->bufp < in->limitp && (len < 0 || done < len) )
+  { if ( Sputc(Sgetc(in), out) < 0 )
+      return -1;
+    done++;
+  }
+  if ( Sflush(out) < 0 )
+    return -1;
 
-  if ( rc == -1 && errno == EBADF )
-  { errno = 0;
-    return 0;
+  while( (len < 0 || done < len) && method < KC_NONE )
+  { size_t chunk = (len < 0 || len-done > KC_CHUNK) ? KC_CHUNK
+						      : (size_t)(len-done);
+    ssize_t n = kernel_copy(method, fdin, fdout, chunk);
+
+    if ( n > 0 )
+    { done += n;
+      skip_position(in, n);
+      skip_position(out, n);
+      moved = true;
+    } else if ( n == 0 )
+    { break;				/* end of file or refused */
+    } else if ( errno != EINTR )
+    { if ( moved )
+	break;				/* let the caller handle it */
+      method++;				/* try the next one */
+      continue;
+    }
+
+    if ( PL_handle_signals() < 0 )
+      return -1;
   }
 
-  return rc;
+  return done;
 }
 
 
-IOFUNCTIONS Sttyfunctions =
-{ Sread_tty,
-  Swrite_tty,
-  Sseek_file,
-  Sclose_tty,
-  Scontrol_file,
-#ifdef O_LARGEFILES
-  Sseek_file64
-#else
-  NULL
-#endif
-};
-
+		 /*******************************
+		 *	   MAPPED FILES		*
+		 *******************************/
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-For now, we use PL_malloc_uncollectable(). In   the  end, this is really
-one of the object-types we want to leave to GC.
+If a regular file is opened for reading   with the `M` flag (open/4 option
+map(true)), we map the entire file  into   memory  and  use the mapping
+as the stream buffer. Reading  the  file   thus  never  calls  read(2) or
+copies data and seeking inside the file only moves s->bufp.
+
+The mapping is private and writable, so Sungetc() does not fault. As the
+mapping holds all data, S__fillbuf() never moves pending data and simply
+returns the next byte. Callers that wait for more data must therefore
+stop if S__fillbuf() does not add any. If the buffer is exhausted,
+Sread_mapped() keeps the window at the end of the file and reports end
+of file. Seeking using SEEK_SET or SEEK_END (which is what Sseek64()
+uses) re-establishes the window. If the user replaces the buffer
+(set_stream/2 buffer_size), we act as a normal file, copying from the
+mapping.
+
+The mapping may be larger than INT_MAX, in which case s->bufsize is
+clamped. As S__fillbuf() does not use s->bufsize for mapped streams,
+this only affects the reported buffer size.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-#ifndef FD_CLOEXEC			/* This is not defined in MacOS */
-#define FD_CLOEXEC 1
-#endif
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H) && !defined(__WINDOWS__)
+#include <sys/mman.h>
+#define O_MAPPED_FILES 1
 
-IOSTREAM *
-Snew(void *handle, int flags, IOFUNCTIONS *functions)
-{ IOSTREAM *s;
+typedef struct map_file
+{ int		fd;			/* Underlying file */
+  char	       *base;			/* Start of the mapping */
+  size_t	size;			/* Size of the mapping */
+  size_t	pos;			/* Offset for next read */
+  IOSTREAM     *stream;			/* Stream using the mapping */
+} map_file;
 
-  if ( !(s = PL_malloc_uncollectable(sizeof(IOSTREAM))) )
-  { errno = ENOMEM;
-    return NULL;
-  }
+static int
+mapped_buffer(const map_file *m)
+{ return m->stream && m->stream->buffer == m->base;
+}
 
-  S__created(s);
+static ssize_t
+Sread_mapped(void *handle, char *buf, size_t size)
+{ map_file *m = handle;
+  size_t n;
 
-  memset((char *)s, 0, sizeof(IOSTREAM));
-  s->magic         = SIO_MAGIC;
-  s->lastc         = EOF;
-  s->flags         = flags;
-  s->handle        = handle;
-  s->functions     = functions;
-  s->timeout       = -1;		/* infinite */
-  s->posbuf.lineno = 1;
-  if ( (flags&SIO_TEXT) )
-  { s->encoding    = initEncoding();
-  } else
-  { s->encoding	   = ENC_OCTET;
-  }
-#if CRLF_MAPPING
-  s->newline       = SIO_NL_DOS;
-#endif
-  if ( flags & SIO_RECORDPOS )
-    s->position = &s->posbuf;
-#ifdef O_PLMT
-  if ( !(flags & SIO_NOMUTEX) )
-  { if ( !(s->mutex = PL_malloc(sizeof(recursiveMutex))) )
-    { PL_free(s);
-      return NULL;
-    }
-    recursiveMutexInit(s->mutex);
+  if ( mapped_buffer(m) )
+  { IOSTREAM *s = m->stream;
+
+    s->bufp = s->limitp = m->base + m->size;
+    return 0;				/* all data is in the buffer */
   }
-#endif
 
-  s->fileno = S__fileno(s);
-  if ( s->fileno >= 0 )
-  { int fd = (int)s->fileno;
+  n = m->pos < m->size ? m->size - m->pos : 0;
+  if ( n > size )
+    n = size;
+  memcpy(buf, m->base+m->pos, n);
+  m->pos += n;
 
-#ifdef __WINDOWS__
-    if ( win_isconsole(s) )
-#else
-    if ( isatty(fd) )
-#endif
-      s->flags |= SIO_ISATTY;
+  return n;
+}
 
-#if defined(F_SETFD)
-    fcntl(fd, F_SETFD, FD_CLOEXEC);
-#elif defined(__WINDOWS__)
-    SetHandleInformation((HANDLE)_get_osfhandle(fd),
-			 HANDLE_FLAG_INHERIT, 0);
-#endif
-  }
+static int64_t
+Sseek_mapped64(void *handle, int64_t pos, int whence)
+{ map_file *m = handle;
+  int64_t newpos;
 
-#ifdef O_LOCALE
+  switch(whence)
+  { case SIO_SEEK_SET:
+      newpos = pos;
+      break;
+    case SIO_SEEK_CUR:
+      newpos = m->pos + pos;
+      break;
+    case SIO_SEEK_END:
+      newpos = m->size + pos;
+      break;
+    default:
+      errno = EINVAL;
+      return -1;
+  }
+
+  if ( newpos < 0 )
+  { errno = EINVAL;
+    return -1;
+  }
+
+  if ( whence != SIO_SEEK_CUR && mapped_buffer(m) )
+  { IOSTREAM *s = m->stream;
+
+    s->bufp   = m->base + ((uint64_t)newpos < m->size ? newpos : m->size);
+    s->limitp = m->base + m->size;
+    m->pos    = m->size;
+  } else
+  { m->pos = newpos;
+  }
+
+  return newpos;
+}
+
+static long
+Sseek_mapped(void *handle, long pos, int whence)
+{ int64_t rc = Sseek_mapped64(handle, pos, whence);
+
+  if ( rc > LONG_MAX )
+  { errno = EINVAL;
+    return -1;
+  }
+
+  return (long)rc;
+}
+
+static int
+Sclose_mapped(void *handle)
+{ map_file *m = handle;
+  int rc;
+
+  munmap(m->base, m->size);
+  rc = Sclose_file((void*)(intptr_t)m->fd);
+  free(m);
+
+  return rc;
+}
+
+static int
+Scontrol_mapped(void *handle, int action, void *arg)
+{ map_file *m = handle;
+
+  switch(action)
+  { case SIO_GETSIZE:
+    { int64_t *rval = arg;
+      *rval = m->size;
+      return 0;
+    }
+    default:
+      return Scontrol_file((void*)(intptr_t)m->fd, action, arg);
+  }
+}
+
+static IOFUNCTIONS Smappedfunctions =
+{ Sread_mapped,
+  NULL,
+  Sseek_mapped,
+  Sclose_mapped,
+  Scontrol_mapped,
+  Sseek_mapped64
+};
+
+/* Create a stream for reading fd using a mapping.  Returns NULL if fd
+ * cannot be mapped, in which case the caller must use the normal file
+ * functions.
+ */
+
+static IOSTREAM *
+Snew_mapped(int fd, int flags)
+{ struct stat st;
+  map_file *m;
+  void *base;
+  IOSTREAM *s;
+
+  if ( fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+       st.st_size == 0 || (uint64_t)st.st_size > (size_t)-1 )
+    return NULL;
+
+  base = mmap(NULL, (size_t)st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE,
+	      fd, 0);
+  if ( base == MAP_FAILED )
+    return NULL;
+#ifdef MADV_SEQUENTIAL
+  madvise(base, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+
+  if ( !(m = malloc(sizeof(*m))) )
+  { munmap(base, (size_t)st.st_size);
+    return NULL;
+  }
+  m->fd     = fd;
+  m->base   = base;
+  m->size   = (size_t)st.st_size;
+  m->pos    = m->size;
+  m->stream = NULL;
+
+  if ( !(s = Snew(m, (flags&~SIO_FILE)|SIO_USERBUF, &Smappedfunctions)) )
+  { munmap(base, m->size);
+    free(m);
+    return NULL;
+  }
+  m->stream   = s;
+  s->unbuffer = s->buffer = s->bufp = base;
+  s->limitp   = s->buffer + m->size;
+  s->bufsize  = m->size > INT_MAX ? INT_MAX : (int)m->size;
+
+  return s;
+}
+
+static int
+S__is_mapped(IOSTREAM *s)
+{ return ( s->functions == &Smappedfunctions &&
+	   mapped_buffer(s->handle) );
+}
+
+#else /*O_MAPPED_FILES*/
+
+static int
+S__is_mapped(IOSTREAM *s)
+{ return false;
+}
+
+#endif /*O_MAPPED_FILES*/
+
+
+		 /*******************************
+		 *	ASYNCHRONOUS FILES	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+If a file is opened with the `A` flag (open/4 option async(Depth)), we
+use Linux io_uring to keep up to  Depth requests of URING_BUFSIZE bytes
+in flight. For input we read ahead,  so   the  stream can process one
+buffer while the next ones are  being   read.  For output we copy the
+data into a free slot and  submit  the   write,  so  the caller can
+continue while the kernel writes the data.   All requests use explicit
+file offsets and thus writes need not complete in order.  This is why
+we do not use this for append mode.  Errors of asynchronous writes are
+reported by the next write, flush or close.
+
+We talk to the kernel directly  rather   than  using liburing. If the
+kernel does not support io_uring, the stream uses Sfilefunctions.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(HAVE_SYS_SYSCALL_H) && \
+    defined(HAVE_SYS_MMAN_H)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define O_URING_FILES 1
+
+#define URING_BUFSIZE	(64*1024)
+#define URING_MAXDEPTH	64
+
+typedef enum
+{ US_FREE = 0,				/* Slot is not used */
+  US_BUSY,				/* Request is in flight */
+  US_DONE				/* Request completed */
+} uring_state;
+
+typedef struct uring_slot
+{ struct iovec	iov;			/* Buffer and requested size */
+  int64_t	offset;			/* File offset of the request */
+  ssize_t	result;			/* Result of completed request */
+  uring_state	state;
+} uring_slot;
+
+typedef struct uring_file
+{ int		fd;			/* Underlying file */
+  int		ring_fd;		/* The io_uring instance */
+  int		output;			/* Stream is for output */
+  int		depth;			/* Number of slots */
+  unsigned     *sq_head;		/* Submission queue */
+  unsigned     *sq_tail;
+  unsigned     *sq_mask;
+  unsigned     *sq_array;
+  struct io_uring_sqe *sqes;
+  unsigned     *cq_head;		/* Completion queue */
+  unsigned     *cq_tail;
+  unsigned     *cq_mask;
+  struct io_uring_cqe *cqes;
+  void	       *sq_ring;		/* Mapped rings */
+  size_t	sq_ring_size;
+  void	       *cq_ring;
+  size_t	cq_ring_size;
+  size_t	sqes_size;
+  int64_t	pos;			/* Logical file position */
+  int64_t	rpos;			/* Offset of next read ahead */
+  int		head;			/* Next slot to consume or fill */
+  int		queued;			/* # input slots in use */
+  size_t	consumed;		/* Bytes consumed from head slot */
+  int		in_flight;		/* # requests in flight */
+  int		error;			/* errno of failed asynchronous write */
+  uring_slot	slots[URING_MAXDEPTH];
+} uring_file;
+
+/* Submit queued requests and, if `wait`, wait for at least one
+ * completion.  If `signals` is false we cannot be interrupted, which
+ * is needed if we must wait for the kernel to release our buffers.
+ */
+
+static int
+uring_enter(uring_file *u, unsigned wait, int signals)
+{ for(;;)
+  { unsigned todo = *u->sq_tail - __atomic_load_n(u->sq_head,
+						  __ATOMIC_ACQUIRE);
+
+    if ( syscall(__NR_io_uring_enter, u->ring_fd, todo, wait,
+		 wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0) >= 0 )
+      return 0;
+    if ( errno != EINTR )
+      return -1;
+    if ( signals && PL_handle_signals() < 0 )
+    { errno = EPLEXCEPTION;
+      return -1;
+    }
+  }
+}
+
+static void
+uring_write_done(uring_file *u, uring_slot *sl)
+{ if ( sl->result < 0 )
+  { if ( !u->error )
+      u->error = (int)-sl->result;
+  } else
+  { size_t done = (size_t)sl->result;
+
+    while( done < sl->iov.iov_len )	/* short write */
+    { ssize_t n = pwrite(u->fd, (char*)sl->iov.iov_base+done,
+			 sl->iov.iov_len-done, sl->offset+done);
+
+      if ( n <= 0 )
+      { if ( n < 0 && errno == EINTR )
+	  continue;
+	if ( !u->error )
+	  u->error = n < 0 ? errno : EIO;
+	break;
+      }
+      done += n;
+    }
+  }
+
+  sl->state = US_FREE;
+}
+
+static void
+uring_reap(uring_file *u)
+{ unsigned head = *u->cq_head;
+  unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+
+  for(; head != tail; head++)
+  { struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+    uring_slot *sl = &u->slots[cqe->user_data];
+
+    sl->result = cqe->res;
+    sl->state  = US_DONE;
+    u->in_flight--;
+    if ( u->output )
+      uring_write_done(u, sl);
+  }
+
+  __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static int
+uring_wait(uring_file *u, uring_slot *sl, int signals)
+{ for(;;)
+  { uring_reap(u);
+    if ( sl->state != US_BUSY )
+      return 0;
+    if ( uring_enter(u, 1, signals) < 0 )
+      return -1;
+  }
+}
+
+static int
+uring_drain(uring_file *u)
+{ for(;;)
+  { uring_reap(u);
+    if ( u->in_flight == 0 )
+      return 0;
+    if ( uring_enter(u, 1, false) < 0 )
+      return -1;
+  }
+}
+
+static int
+uring_submit(uring_file *u, int slot, int op)
+{ uring_slot *sl = &u->slots[slot];
+  unsigned tail = *u->sq_tail;
+  unsigned idx = tail & *u->sq_mask;
+  struct io_uring_sqe *sqe = &u->sqes[idx];
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode    = op;
+  sqe->fd        = u->fd;
+  sqe->addr      = (uintptr_t)&sl->iov;
+  sqe->len       = 1;
+  sqe->off       = sl->offset;
+  sqe->user_data = slot;
+  u->sq_array[idx] = idx;
+  __atomic_store_n(u->sq_tail, tail+1, __ATOMIC_RELEASE);
+  sl->state = US_BUSY;
+  u->in_flight++;
+
+  return uring_enter(u, 0, false);
+}
+
+/* Discard the read ahead, e.g., after a seek or end-of-file.
+ */
+
+static int
+uring_reset_input(uring_file *u)
+{ int i;
+
+  if ( uring_drain(u) < 0 )
+    return -1;
+  for(i=0; i<u->depth; i++)
+    u->slots[i].state = US_FREE;
+  u->head     = 0;
+  u->queued   = 0;
+  u->consumed = 0;
+  u->rpos     = u->pos;
+
+  return 0;
+}
+
+static int
+uring_read_ahead(uring_file *u)
+{ while( u->queued < u->depth )
+  { int slot = (u->head + u->queued) % u->depth;
+    uring_slot *sl = &u->slots[slot];
+
+    sl->iov.iov_len = URING_BUFSIZE;
+    sl->offset      = u->rpos;
+    if ( uring_submit(u, slot, IORING_OP_READV) < 0 )
+      return -1;
+    u->rpos += URING_BUFSIZE;
+    u->queued++;
+  }
+
+  return 0;
+}
+
+static ssize_t
+Sread_uring(void *handle, char *buf, size_t size)
+{ uring_file *u = handle;
+  uring_slot *sl;
+  size_t n;
+
+  if ( uring_read_ahead(u) < 0 )
+    return -1;
+  sl = &u->slots[u->head];
+  if ( uring_wait(u, sl, true) < 0 )
+    return -1;
+
+  if ( sl->result <= 0 )		/* error or end-of-file */
+  { ssize_t rc = sl->result;
+
+    if ( uring_reset_input(u) < 0 )
+      return -1;
+    if ( rc < 0 )
+    { errno = (int)-rc;
+      return -1;
+    }
+    return 0;
+  }
+
+  n = (size_t)sl->result - u->consumed;
+  if ( n > size )
+    n = size;
+  memcpy(buf, (char*)sl->iov.iov_base+u->consumed, n);
+  u->consumed += n;
+  u->pos      += n;
+
+  if ( u->consumed == (size_t)sl->result )
+  { if ( u->consumed < sl->iov.iov_len ) /* short read; restart at pos */
+    { if ( uring_reset_input(u) < 0 )
+	return -1;
+    } else
+    { sl->state   = US_FREE;
+      u->head     = (u->head+1) % u->depth;
+      u->queued--;
+      u->consumed = 0;
+    }
+  }
+
+  return n;
+}
+
+static ssize_t
+Swrite_uring(void *handle, char *buf, size_t size)
+{ uring_file *u = handle;
+  uring_slot *sl = &u->slots[u->head];
+
+  if ( uring_wait(u, sl, true) < 0 )
+    return -1;
+  if ( u->error )
+  { errno = u->error;
+    u->error = 0;
+    return -1;
+  }
+
+  if ( size > URING_BUFSIZE )
+    size = URING_BUFSIZE;
+  memcpy(sl->iov.iov_base, buf, size);
+  sl->iov.iov_len = size;
+  sl->offset      = u->pos;
+  if ( uring_submit(u, u->head, IORING_OP_WRITEV) < 0 )
+    return -1;
+  u->pos  += size;
+  u->head  = (u->head+1) % u->depth;
+
+  return size;
+}
+
+static int
+uring_flush(uring_file *u)
+{ if ( uring_drain(u) < 0 )
+    return -1;
+  if ( u->error )
+  { errno = u->error;
+    u->error = 0;
+    return -1;
+  }
+
+  return 0;
+}
+
+static int64_t
+Sseek_uring64(void *handle, int64_t pos, int whence)
+{ uring_file *u = handle;
+  int64_t newpos;
+
+  switch(whence)
+  { case SIO_SEEK_SET:
+      newpos = pos;
+      break;
+    case SIO_SEEK_CUR:
+      newpos = u->pos + pos;
+      break;
+    case SIO_SEEK_END:
+    { struct stat buf;
+
+      if ( (u->output && uring_flush(u) < 0) ||
+	   fstat(u->fd, &buf) != 0 )
+	return -1;
+      newpos = buf.st_size + pos;
+      break;
+    }
+    default:
+      errno = EINVAL;
+      return -1;
+  }
+
+  if ( newpos < 0 )
+  { errno = EINVAL;
+    return -1;
+  }
+
+  if ( newpos != u->pos )
+  { u->pos = newpos;
+    if ( !u->output && uring_reset_input(u) < 0 )
+      return -1;
+  }
+
+  return newpos;
+}
+
+static long
+Sseek_uring(void *handle, long pos, int whence)
+{ int64_t rc = Sseek_uring64(handle, pos, whence);
+
+  if ( rc > LONG_MAX )
+  { errno = EINVAL;
+    return -1;
+  }
+
+  return (long)rc;
+}
+
+static void
+uring_free(uring_file *u)
+{ int i;
+
+  if ( u->sqes )
+    munmap(u->sqes, u->sqes_size);
+  if ( u->cq_ring )
+    munmap(u->cq_ring, u->cq_ring_size);
+  if ( u->sq_ring )
+    munmap(u->sq_ring, u->sq_ring_size);
+  if ( u->ring_fd >= 0 )
+    close(u->ring_fd);
+  for(i=0; i<u->depth; i++)
+    free(u->slots[i].iov.iov_base);
+  free(u);
+}
+
+static int
+Sclose_uring(void *handle)
+{ uring_file *u = handle;
+  int rc = 0;
+  int eno = 0;
+
+  if ( uring_drain(u) < 0 )
+  { int i;
+
+    eno = errno;
+    rc = -1;
+    for(i=0; i<u->depth; i++)		/* the kernel may still use these */
+    { if ( u->slots[i].state == US_BUSY )
+	u->slots[i].iov.iov_base = NULL;
+    }
+  } else if ( u->error )
+  { eno = u->error;
+    rc = -1;
+  }
+  if ( Sclose_file((void*)(intptr_t)u->fd) < 0 && !eno )
+  { eno = errno;
+    rc = -1;
+  }
+  uring_free(u);
+  if ( rc < 0 )
+    errno = eno;
+
+  return rc;
+}
+
+static int
+Scontrol_uring(void *handle, int action, void *arg)
+{ uring_file *u = handle;
+
+  switch(action)
+  { case SIO_FLUSHOUTPUT:
+      return uring_flush(u);
+    case SIO_GETSIZE:
+      if ( u->output && uring_flush(u) < 0 )
+	return -1;
+      /*FALLTHROUGH*/
+    default:
+      return Scontrol_file((void*)(intptr_t)u->fd, action, arg);
+  }
+}
+
+static IOFUNCTIONS Suringfunctions =
+{ Sread_uring,
+  Swrite_uring,
+  Sseek_uring,
+  Sclose_uring,
+  Scontrol_uring,
+  Sseek_uring64
+};
+
+static void *
+uring_map(int ring_fd, size_t size, off_t offset)
+{ void *p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+		 ring_fd, offset);
+
+  return p == MAP_FAILED ? NULL : p;
+}
+
+/* Create a stream for fd that uses io_uring with `depth` slots.
+ * Returns NULL if io_uring is not available, in which case the caller
+ * must use the normal file functions.
+ */
+
+static IOSTREAM *
+Snew_uring(int fd, int flags, int depth)
+{ struct io_uring_params p;
+  struct stat st;
+  uring_file *u;
+  IOSTREAM *s;
+  int i;
+
+  if ( fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) )
+    return NULL;			/* we use explicit offsets */
+
+  if ( depth < 2 )			/* at least double buffering */
+    depth = 2;
+  else if ( depth > URING_MAXDEPTH )
+    depth = URING_MAXDEPTH;
+
+  if ( !(u = calloc(1, sizeof(*u))) )
+    return NULL;
+  u->fd      = fd;
+  u->output  = (flags & SIO_OUTPUT) != 0;
+  u->depth   = depth;
+  memset(&p, 0, sizeof(p));
+  if ( (u->ring_fd = (int)syscall(__NR_io_uring_setup, depth, &p)) < 0 )
+    goto failed;
+
+  u->sq_ring_size = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+  u->cq_ring_size = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+  u->sqes_size    = p.sq_entries*sizeof(struct io_uring_sqe);
+  if ( !(u->sq_ring = uring_map(u->ring_fd, u->sq_ring_size,
+				IORING_OFF_SQ_RING)) ||
+       !(u->cq_ring = uring_map(u->ring_fd, u->cq_ring_size,
+				IORING_OFF_CQ_RING)) ||
+       !(u->sqes    = uring_map(u->ring_fd, u->sqes_size,
+				IORING_OFF_SQES)) )
+    goto failed;
+
+  u->sq_head  = (unsigned*)((char*)u->sq_ring + p.sq_off.head);
+  u->sq_tail  = (unsigned*)((char*)u->sq_ring + p.sq_off.tail);
+  u->sq_mask  = (unsigned*)((char*)u->sq_ring + p.sq_off.ring_mask);
+  u->sq_array = (unsigned*)((char*)u->sq_ring + p.sq_off.array);
+  u->cq_head  = (unsigned*)((char*)u->cq_ring + p.cq_off.head);
+  u->cq_tail  = (unsigned*)((char*)u->cq_ring + p.cq_off.tail);
+  u->cq_mask  = (unsigned*)((char*)u->cq_ring + p.cq_off.ring_mask);
+  u->cqes     = (struct io_uring_cqe*)((char*)u->cq_ring + p.cq_off.cqes);
+
+  for(i=0; i<depth; i++)
+  { if ( !(u->slots[i].iov.iov_base = malloc(URING_BUFSIZE)) )
+      goto failed;
+  }
+
+  if ( !(s = Snew(u, flags&~SIO_FILE, &Suringfunctions)) )
+    goto failed;
+
+  return s;
+
+failed:
+  uring_free(u);
+  return NULL;
+}
+#endif /*__NR_io_uring_setup*/
+#endif /*HAVE_LINUX_IO_URING_H*/
+
+/* Return the number of requests the stream keeps in flight if it uses
+ * io_uring (open/4 option async(Depth)) and 0 otherwise.
+ */
+
+int
+Sasync_depth(IOSTREAM *s)
+{
+#ifdef O_URING_FILES
+  if ( s->functions == &Suringfunctions )
+    return ((uring_file*)s->handle)->depth;
+#endif
+  (void)s;
+  return 0;
+}
+
+
+		 /*******************************
+		 *	    TTY STREAMS		*
+		 *******************************/
+
+static ssize_t
+Sread_tty(void *handle, char *buf, size_t size)
+{ ssize_t bytes = Sread_file(handle, buf, size);
+
+  if ( bytes < 0 && errno == EBADF )
+  { errno = 0;
+    return 0;
+  }
+
+  return bytes;
+}
+
+
+static ssize_t
+Swrite_tty(void *handle, char *buf, size_t size)
+{ ssize_t bytes = Swrite_file(handle, buf, size);
+
+  if ( bytes == -1 && errno == EBADF )
+  { errno = 0;
+    return size;
+  }
+
+  return bytes;
+}
+
+
+static int
+Sclose_tty(void *handle)
+{ int rc = Sclose_file(handle);
+
+  if ( rc == -1 && errno == EBADF )
+  { errno = 0;
+    return 0;
+  }
+
+  return rc;
+}
+
+
+IOFUNCTIONS Sttyfunctions =
+{ Sread_tty,
+  Swrite_tty,
+  Sseek_file,
+  Sclose_tty,
+  Scontrol_file,
+#ifdef O_LARGEFILES
+  Sseek_file64
+#else
+  NULL
+#endif
+};
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+For now, we use PL_malloc_uncollectable(). In   the  end, this is really
+one of the object-types we want to leave to GC.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#ifndef FD_CLOEXEC			/* This is not defined in MacOS */
+#define FD_CLOEXEC 1
+#endif
+
+IOSTREAM *
+Snew(void *handle, int flags, IOFUNCTIONS *functions)
+{ IOSTREAM *s;
+
+  if ( !(s = S__alloc_stream(!(flags & SIO_NOMUTEX))) )
+  { errno = ENOMEM;
+    return NULL;
+  }
+
+  S__created(s);
+
+  s->magic         = SIO_MAGIC;
+  s->lastc         = EOF;
+  s->flags         = flags;
+  s->handle        = handle;
+  s->functions     = functions;
+  s->timeout       = -1;		/* infinite */
+  s->posbuf.lineno = 1;
+  if ( (flags&SIO_TEXT) )
+  { s->encoding    = initEncoding();
+  } else
+  { s->encoding	   = ENC_OCTET;
+  }
+#if CRLF_MAPPING
+  s->newline       = SIO_NL_DOS;
+#endif
+  if ( flags & SIO_RECORDPOS )
+    s->position = &s->posbuf;
+
+  s->fileno = S__fileno(s);
+  if ( s->fileno >= 0 )
+  { int fd = (int)s->fileno;
+
+#ifdef __WINDOWS__
+    if ( win_isconsole(s) )
+#else
+    if ( isatty(fd) )
+#endif
+      s->flags |= SIO_ISATTY;
+
+#if defined(F_SETFD)
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+#elif defined(__WINDOWS__)
+    SetHandleInformation((HANDLE)_get_osfhandle(fd),
+			 HANDLE_FLAG_INHERIT, 0);
+#endif
+  }
+
+#ifdef O_LOCALE
   initStreamLocale(s);
 #endif
 
@@ -3428,6 +4938,8 @@ Sopen_file(const char *path, const char *how)
   int op = *how++;
   intptr_t lfd;
   enum {lnone=0,lread,lwrite} lock = lnone;
+  int map = false;
+  int depth = 0;
   IOSTREAM *s;
   IOENC enc = ENC_UNKNOWN;
   int wait = true;
@@ -3455,6 +4967,18 @@ Sopen_file(const char *path, const char *how)
 	  return NULL;
 	}
 	break;
+      case 'M':				/* map into memory */
+	map = true;
+	break;
+      case 'A':				/* asynchronous I/O, 2 digit depth */
+	if ( isdigit(how[1]&0xff) && isdigit(how[2]&0xff) )
+	{ depth = (how[1]-'0')*10 + (how[2]-'0');
+	  how += 2;
+	  break;
+	} else
+	{ errno = EINVAL;
+	  return NULL;
+	}
       case 'm':
 	if ( get_mode(how+1, &mode) )
 	{ how += 3;
@@ -3552,8 +5076,32 @@ Sopen_file(const char *path, const char *how)
 #endif
   }
 
-  lfd = (intptr_t)fd;
-  s = Snew((void *)lfd, flags, &Sfilefunctions);
+  s = NULL;
+#ifdef O_MAPPED_FILES
+  if ( map && op == 'r' )
+    s = Snew_mapped(fd, flags);
+#else
+  (void)map;
+#endif
+#ifdef O_URING_FILES
+  if ( !s && depth > 0 && op != 'a' )
+    s = Snew_uring(fd, flags, depth);
+#else
+  (void)depth;
+#endif
+  if ( !s )
+  {
+#ifdef S_ISREG
+    struct stat st;
+#endif
+
+    lfd = (intptr_t)fd;
+    s = Snew((void *)lfd, flags, &Sfilefunctions);
+#ifdef S_ISREG
+    if ( fstat(fd, &st) == 0 && S_ISREG(st.st_mode) )
+      s->bufmax = S__bufmax;		/* only grow buffers of files */
+#endif
+  }
   if ( enc != ENC_UNKNOWN )
     s->encoding = enc;
   if ( lock )
@@ -3837,6 +5385,12 @@ Sopen_pipe(const char *command, const char *type)
 	case 'b':
 	  flags &= ~SIO_TEXT;
 	  break;
+	case 'M':			/* map(true): files only */
+	  break;
+	case 'A':			/* async(Depth): files only */
+	  while( isdigit(type[1]&0xff) )
+	    type++;
+	  break;
 	default:
 	  assert(0);
       }
@@ -3871,6 +5425,7 @@ typedef struct
   char	      **bufferp;		/* Write-back location */
   int		malloced;		/* malloc() maintained */
   int		free_on_close;		/* free allocated buffer on close */
+  IOSTREAM     *stream;			/* Stream for direct output */
 } memfile;
 
 
@@ -3891,49 +5446,130 @@ S__memfile_nextsize(size_t needed)
 }
 
 
-static ssize_t
-Swrite_memfile(void *handle, char *buf, size_t size)
-{ memfile *mf = handle;
-
-  if ( mf->here + size + 1 >= mf->allocated )
-  { size_t ns = S__memfile_nextsize(mf->here + size + 1);
-    char *nb;
+static int
+S__memfile_grow(memfile *mf, size_t needed)
+{ size_t ns = S__memfile_nextsize(needed);
+  char *nb;
 
-    if ( mf->allocated == 0 || !mf->malloced )
-    { if ( !(nb = malloc(ns)) )
-      { errno = ENOMEM;
-	return -1;
-      }
-      if ( !mf->malloced )
-      { if ( mf->buffer )
-	  memcpy(nb, mf->buffer, mf->allocated);
-	mf->malloced = true;
-      }
-    } else
-    { if ( !(nb = realloc(mf->buffer, ns)) )
-      { errno = ENOMEM;
-	return -1;
-      }
+  if ( mf->allocated == 0 || !mf->malloced )
+  { if ( !(nb = malloc(ns)) )
+    { errno = ENOMEM;
+      return -1;
+    }
+    if ( !mf->malloced )
+    { if ( mf->buffer )
+	memcpy(nb, mf->buffer, mf->allocated);
+      mf->malloced = true;
+    }
+  } else
+  { if ( !(nb = realloc(mf->buffer, ns)) )
+    { errno = ENOMEM;
+      return -1;
     }
-
-    mf->allocated = ns;
-    *mf->bufferp = mf->buffer = nb;
   }
 
-  memcpy(&mf->buffer[mf->here], buf, size);
-  mf->here += size;
+  mf->allocated = ns;
+  *mf->bufferp = mf->buffer = nb;
 
-  if ( mf->here > mf->size )
+  return 0;
+}
+
+
+static void
+S__memfile_written(memfile *mf)
+{ if ( mf->here > mf->size )
   { mf->size = mf->here;
     if ( mf->sizep )			/* make externally known */
       *mf->sizep = mf->size;
     mf->buffer[mf->size] = '\0';
   }
+}
+
+
+static ssize_t
+Swrite_memfile(void *handle, char *buf, size_t size)
+{ memfile *mf = handle;
+
+  if ( mf->here + size + 1 >= mf->allocated &&
+       S__memfile_grow(mf, mf->here + size + 1) < 0 )
+    return -1;
+
+  memcpy(&mf->buffer[mf->here], buf, size);
+  mf->here += size;
+  S__memfile_written(mf);
 
   return size;
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Output memory streams write directly into the  memory buffer: the stream
+buffer is the unused part of the  memfile   buffer  after `here', leaving
+room for the terminating 0-byte. Flushing  merely accounts for the data
+in the window and, if the window  is   full,  grows  the memfile buffer
+geometrically.  This avoids copying all  output   from  a separate stream
+buffer and the repeated realloc() calls for growing the memfile in steps
+of the stream buffer size.  If the user replaces the stream buffer using
+Ssetbuffer(), the stream behaves as a normal buffered stream.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define MEMFILE_MIN_WINDOW 256
+
+static int
+S__memfile_is_direct(IOSTREAM *s)
+{ memfile *mf = s->handle;
+
+  return ( s->functions->write == Swrite_memfile &&
+	   mf->stream == s &&
+	   s->buffer == mf->buffer + mf->here );
+}
+
+static void
+S__memfile_window(IOSTREAM *s, memfile *mf)
+{ size_t size = mf->allocated - 1 - mf->here;
+
+  s->unbuffer = s->buffer = s->bufp = mf->buffer + mf->here;
+  s->limitp   = s->buffer + size;
+  s->bufsize  = (size > INT_MAX ? INT_MAX : (int)size);
+}
+
+static int
+S__memfile_direct(IOSTREAM *s)
+{ memfile *mf = s->handle;
+
+  if ( mf->here + MEMFILE_MIN_WINDOW + 1 >= mf->allocated &&
+       S__memfile_grow(mf, mf->here + MEMFILE_MIN_WINDOW + 1) < 0 )
+    return -1;
+
+  mf->stream = s;
+  s->flags |= SIO_USERBUF;
+  S__memfile_window(s, mf);
+
+  return 0;
+}
+
+/* Called by S__flushbuf() for a direct memory stream */
+
+static ssize_t
+S__flush_memfile(IOSTREAM *s)
+{ memfile *mf = s->handle;
+  size_t n = s->bufp - s->buffer;
+  int full = (s->bufp >= s->limitp);
+
+  mf->here += n;
+  S__memfile_written(mf);
+
+  if ( full && S__memfile_grow(mf, mf->here + MEMFILE_MIN_WINDOW + 1) < 0 )
+  { S__memfile_window(s, mf);
+    S__seterror(s);
+    return -1;
+  }
+  S__memfile_window(s, mf);
+
+  return n;
+}
+
+
 static ssize_t
 Sread_memfile(void *handle, char *buf, size_t size)
 { memfile *mf = handle;
@@ -3973,7 +5609,13 @@ Sseek_memfile64(void *handle, int64_t offset, int whence)
   { errno = EINVAL;
     return -1;
   }
-  mf->here = (size_t)offset;
+  if ( whence != SIO_SEEK_CUR && mf->stream &&
+       S__memfile_is_direct(mf->stream) )
+  { mf->here = (size_t)offset;		/* Sseek64() flushed the window */
+    S__memfile_window(mf->stream, mf);
+  } else
+  { mf->here = (size_t)offset;
+  }
 
   return offset;
 }
@@ -4097,6 +5739,7 @@ Sopenmem(char **bufp, size_t *sizep, const char *mode)
 
   mf->malloced      = false;
   mf->free_on_close = false;
+  mf->stream        = NULL;
   mf->bufferp       = bufp;
   mf->buffer        = *bufp;
 
@@ -4139,7 +5782,14 @@ Sopenmem(char **bufp, size_t *sizep, const char *mode)
   mf->here      = 0;
 
   if ( (s=Snew(mf, flags, &Smemfunctions)) )
-    s->newline = SIO_NL_POSIX;
+  { s->newline = SIO_NL_POSIX;
+    if ( (flags&(SIO_INPUT|SIO_OUTPUT)) == SIO_OUTPUT &&
+	 S__memfile_direct(s) < 0 )
+    { Sclose(s);
+      errno = ENOMEM;
+      return NULL;
+    }
+  }
 
   return s;
 }
@@ -4199,14 +5849,15 @@ Sopen_string(IOSTREAM *s, char *buf, size_t size, const char *mode)
 { int flags = SIO_FBUF|SIO_USERBUF;
 
   if ( !s )
-  { if ( !(s = PL_malloc_uncollectable(sizeof(IOSTREAM))) ) /* TBD: Use GC */
+  { if ( !(s = S__alloc_stream(false)) )
     { errno = ENOMEM;
       return NULL;
     }
   } else
-    flags |= SIO_STATIC;
+  { flags |= SIO_STATIC;
+    memset((char *)s, 0, sizeof(IOSTREAM));
+  }
 
-  memset((char *)s, 0, sizeof(IOSTREAM));
   s->timeout   = -1;
   s->buffer    = buf;
   s->bufp      = buf;
@@ -4428,6 +6079,10 @@ Scleanup(void)
   }
 
   close_hooks = NULL;
+  S__free_pool(S__thread_pool(false));
+  LOCK_POOL();
+  S__free_pool(&S__shared_pool);
+  UNLOCK_POOL();
 
   for(i=0; i<=2; i++)
   { IOSTREAM *s = &S__iob[i];
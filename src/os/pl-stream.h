@@ -44,6 +44,8 @@
 void		unallocStream(IOSTREAM *s);
 IOSTREAM       *Sacquire(IOSTREAM *s);
 int             Srelease(IOSTREAM *s);
+int64_t		Scopy_fd(IOSTREAM *in, IOSTREAM *out, int64_t len);
+int		Sasync_depth(IOSTREAM *s);
 
 #ifndef _PL_INCLUDE_H
 #ifdef O_PLMT
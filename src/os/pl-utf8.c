@@ -35,7 +35,11 @@
 */
 
 #include <string.h>			/* get size_t */
+#include <stdint.h>
 #include "pl-utf8.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 UTF-8 Decoding, based on http://www.cl.cam.ac.uk/~mgk25/unicode.html
@@ -180,6 +184,44 @@ utf8_strlen(const char *s, size_t len)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+utf8_ascii_span() returns the length of the  longest prefix of `s` that
+only holds 7-bit ASCII bytes.  This is used by the bulk text I/O routines
+to process runs of ASCII text without decoding individual characters. We
+test 16 bytes at a time using SSE2 if available and 8 bytes at a time in
+a word otherwise.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+size_t
+utf8_ascii_span(const char *s, size_t len)
+{ const char *q = s;
+  const char *e = s+len;
+
+#ifdef __SSE2__
+  while( q+16 <= e )
+  { __m128i v = _mm_loadu_si128((const __m128i*)q);
+    int m = _mm_movemask_epi8(v);
+
+    if ( m )
+      return (q-s) + __builtin_ctz(m);
+    q += 16;
+  }
+#endif
+  while( q+8 <= e )
+  { uint64_t w;
+
+    memcpy(&w, q, sizeof(w));
+    if ( (w & 0x8080808080808080ULL) )
+      break;
+    q += 8;
+  }
+  while( q < e && !(*q&0x80) )
+    q++;
+
+  return q-s;
+}
+
+
 size_t
 utf8_strlen1(const char *s)
 { unsigned int l = 0;
@@ -74,6 +74,7 @@ extern char *_PL__utf8_skip_char(const char *out);
 
 extern size_t utf8_strlen(const char *s, size_t len);
 extern size_t utf8_strlen1(const char *s);
+extern size_t utf8_ascii_span(const char *s, size_t len);
 extern const char *utf8_skip(const char *s, size_t n);
 extern int    utf8_strncmp(const char *s1, const char *s2, size_t n);
 
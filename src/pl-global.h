@@ -473,6 +473,7 @@ struct PL_global_data
 		 *******************************/
 
 #define LD_MAGIC	0x3cfd82b4	/* Valid local-data structure */
+#define FORMAT_CACHE_SIZE 64		/* # cached format/2 programs */
 
 struct PL_local_data
 { uintptr_t	magic;			/* LD_MAGIC */
@@ -536,6 +537,12 @@ struct PL_local_data
 
   source_location read_source;		/* file, line, char of last term */
 
+  struct				/* pl-read.c */
+  { struct read_cache *cache;		/* reusable reader memory */
+    size_t	reused;			/* blocks taken from the cache */
+    size_t	allocated;		/* blocks allocated or enlarged */
+  } reader;
+
   struct
   { term_t	term;			/* exception term */
     term_t	bin;			/* temporary handle for exception */
@@ -567,6 +574,10 @@ struct PL_local_data
     int		top;			/* Top-of-stack index */
   } tmp;
 
+  struct				/* pl-fmt.c */
+  { struct format_program *cache[FORMAT_CACHE_SIZE]; /* compiled formats */
+  } format;
+
 #ifdef O_GVAR
   struct
   { Table	nb_vars;		/* atom --> value */
@@ -693,6 +704,12 @@ struct PL_local_data
     term_t delay_list;			/* Global delay list */
     term_t idg_current;			/* Current node in IDG (trie symbol) */
     struct
+    { int	 depth;			/* Nesting of batches */
+      Table	 pending;		/* trie symbol -> true */
+      uint64_t	 changes;		/* # IDG change requests */
+      uint64_t	 coalesced;		/* # requests merged in a batch */
+    } idg_batch;
+    struct
     { atom_t max_table_subgoal_size_action;
       size_t max_table_subgoal_size;
       atom_t max_table_answer_size_action;
@@ -759,6 +776,7 @@ struct PL_local_data
     struct input_context *input_stack;	/* maintain input stream info */
     struct output_context *output_stack; /* maintain output stream info */
     int	portray_nesting;		/* depth of portray nesting */
+    bool owns_streams;			/* used set_stream(S, owned(true)) */
   } IO;
 
   struct
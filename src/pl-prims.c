@@ -4596,6 +4596,61 @@ PRED_IMPL("atomic_concat", 3, atomic_concat, PL_FA_ISO)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+find_text() returns the offset of the first  occurrence of `needle` in
+`hay` at or after `from` or SIZE_NOT_SET if there is no such occurrence.
+If both texts use the same encoding we use memchr() or wmemchr() to find
+candidates from the first character. These are vectorised in any decent
+C library. We then check the last character before comparing the
+rest. Mixed encodings are rare and handled using PL_cmp_text().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static size_t
+find_text(PL_chars_t *hay, size_t from, size_t lh,
+	  PL_chars_t *needle, size_t ln)
+{ if ( from > lh || lh - from < ln )
+    return SIZE_NOT_SET;
+  if ( ln == 0 )
+    return from;
+
+  if ( hay->encoding == ENC_ISO_LATIN_1 &&
+       needle->encoding == ENC_ISO_LATIN_1 )
+  { const unsigned char *h = (const unsigned char *)hay->text.t;
+    const unsigned char *n = (const unsigned char *)needle->text.t;
+    const unsigned char *s = h+from;
+    const unsigned char *e = h+lh-ln;	/* last possible start */
+
+    while( (s = memchr(s, n[0], e-s+1)) )
+    { if ( s[ln-1] == n[ln-1] && memcmp(s+1, n+1, ln-1) == 0 )
+	return s-h;
+      if ( ++s > e )
+	break;
+    }
+    return SIZE_NOT_SET;
+  } else if ( hay->encoding == ENC_WCHAR &&
+	      needle->encoding == ENC_WCHAR )
+  { const pl_wchar_t *h = hay->text.w;
+    const pl_wchar_t *n = needle->text.w;
+    const pl_wchar_t *s = h+from;
+    const pl_wchar_t *e = h+lh-ln;
+
+    while( (s = wmemchr(s, n[0], e-s+1)) )
+    { if ( s[ln-1] == n[ln-1] && wmemcmp(s+1, n+1, ln-1) == 0 )
+	return s-h;
+      if ( ++s > e )
+	break;
+    }
+    return SIZE_NOT_SET;
+  } else
+  { for( ; from+ln <= lh; from++ )
+    { if ( PL_cmp_text(hay, from, needle, 0, ln) == CMP_EQUAL )
+	return from;
+    }
+    return SIZE_NOT_SET;
+  }
+}
+
+
 #define split_atom(list, st, atom) LDFUNC(split_atom, list, st, atom)
 static int
 split_atom(DECL_LD term_t list, PL_chars_t *st, term_t atom)
@@ -4608,15 +4663,12 @@ split_atom(DECL_LD term_t list, PL_chars_t *st, term_t atom)
   if ( !PL_get_text(atom, &at, CVT_ATOMIC|CVT_EXCEPTION) )
     return false;
 
-  for(last=i=0; (ssize_t)i<=(ssize_t)(at.length-sep_len); )
-  { if ( PL_cmp_text(st, 0, &at, i, sep_len) == 0 )
-    { if ( !PL_unify_list(tail, head, tail) ||
-	   !PL_unify_text_range(head, &at, last, i-last, PL_ATOM) )
-	fail;
-      i += sep_len;
-      last = i;
-    } else
-      i++;
+  for(last=0;
+      (i=find_text(&at, last, at.length, st, sep_len)) != SIZE_NOT_SET;
+      last = i+sep_len)
+  { if ( !PL_unify_list(tail, head, tail) ||
+	 !PL_unify_text_range(head, &at, last, i-last, PL_ATOM) )
+      fail;
   }
 
   if ( !PL_unify_list(tail, head, tail) ||
@@ -4873,7 +4925,9 @@ There are many possibilities (think the semantics are a bit overloaded).
     * sub is given
 	+ if len conflicts: fail
 	+ if before or after given: test deterministically
-	+ otherwise: search (non-deterministic)
+	+ otherwise: search (non-deterministic).  The next match is
+	  only searched for on backtracking, so only a match at the
+	  end of the text is deterministic.
     * two of the integers are given
 	+ generate (deterministic)
     * before is given:
@@ -4973,9 +5027,16 @@ sub_text(DECL_LD term_t atom,
 	  }
 	  return false;
 	}
+	if ( (b=find_text(&ta, 0, la, &ts, ls)) == SIZE_NOT_SET )
+	  return false;
+	if ( b+ls >= la )
+	{ return ( PL_unify_integer(before, b) &&	/* last position */
+		   PL_unify_integer(len, ls) &&
+		   PL_unify_integer(after, la-ls-b) );
+	}
 	state = allocForeignState(sizeof(*state));
 	state->type = SUB_SEARCH;
-	state->n1   = 0;
+	state->n1   = b;		/* search from here */
 	state->n2   = la;
 	state->n3   = ls;
 	break;
@@ -5076,19 +5137,19 @@ again:
       lab = state->n2;
       lsb = state->n3;
 
-      for( ; state->n1+ls <= la; state->n1++ )
-      { if ( PL_cmp_text(&ta, state->n1, &ts, 0, ls) == 0 )
-	{ match = (PL_unify_integer(before, state->n1) &&
-		   PL_unify_integer(len,    ls) &&
-		   PL_unify_integer(after,  la-ls-state->n1));
+      if ( (b=find_text(&ta, state->n1, la, &ts, ls)) == SIZE_NOT_SET )
+	goto exit_fail;
+      state->n1 = b+1;
 
-	  if ( ++state->n1 + ls > la )
-	    goto exit_succeed;
-	  else
-	    goto next;
-	}
-      }
-      goto exit_fail;
+      match = (PL_unify_integer(before, b) &&
+	       PL_unify_integer(len,    ls) &&
+	       PL_unify_integer(after,  la-ls-b));
+      if ( b+ls < la )
+	goto next;
+      else if ( match )
+	goto exit_succeed;
+      else
+	goto exit_fail;
     }
     case SUB_SPLIT_TAIL:		/* before given, rest unbound */
     { lab = state->n2;
@@ -5932,10 +5993,25 @@ swi_statistics(DECL_LD atom_t key, Number v)
       v->value.i = pool->size;
     else
       v->value.i = 0;
-  } else if (key == ATOM_indexes_created)
+  } else if (key == ATOM_idg_changes)
+    v->value.i = LD->tabling.idg_batch.changes;
+  else if (key == ATOM_idg_changes_coalesced)
+    v->value.i = LD->tabling.idg_batch.coalesced;
+  else if (key == ATOM_indexes_created)
     v->value.i = GD->statistics.indexes.created;
   else if (key == ATOM_indexes_destroyed)
     v->value.i = GD->statistics.indexes.destroyed;
+  else if (key == ATOM_stream_pool_hits ||
+	   key == ATOM_stream_pool_misses)
+  { size_t hits, misses;
+
+    Sstream_pool_statistics(&hits, &misses);
+    v->value.i = (key == ATOM_stream_pool_hits ? hits : misses);
+  }
+  else if (key == ATOM_read_buffers_reused)
+    v->value.i = LD->reader.reused;
+  else if (key == ATOM_read_buffers_allocated)
+    v->value.i = LD->reader.allocated;
   else if (key == ATOM_warnings)
     v->value.i = GD->statistics.warnings;
   else if (key == ATOM_errors)
@@ -470,6 +470,7 @@ typedef struct
 #endif
   bool		cycles;			/* Re-establish cycles */
   bool		dotlists;		/* read .(a,b) as a list */
+  bool		data;			/* syntax(data): no operators */
   int		strictness;		/* Strictness level */
 
   atom_t	locked;			/* atom that must be unlocked */
@@ -501,17 +502,122 @@ static void	init_term_stack(ReadData _PL_rd);
 static void	clear_term_stack(ReadData _PL_rd);
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Per-thread cache for the memory used by the reader.  The tmp_buffers  of
+read_data only have a small static buffer, so reading a clause with more
+than a few variables or  subterms   allocates  memory  for the variable
+table, term stack and operator queues and often also for the read buffer
+and variable hash table. Instead of freeing these blocks at the end of
+each read, free_read_data() returns them to  the cache and the next
+init_read_data() reuses them.  A block is taken  out of the cache while
+in use, so nested reads simply find an empty slot.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define READ_CACHE_MAX	(64*1024)	/* do not cache larger blocks */
+
+#define RC_VAR_NAMES	0		/* var_name_buffer */
+#define RC_VARS		1		/* var_buffer */
+#define RC_OUT_QUEUE	2		/* op.out_queue */
+#define RC_SIDE_QUEUE	3		/* op.side_queue */
+#define RC_TERM_STACK	4		/* term_stack.terms */
+#define RC_BUFFERS	5
+
+typedef struct read_cache
+{ struct
+  { char	       *base;		/* tmp_malloc()'ed block */
+    size_t	size;			/* its size */
+    char	       *lent;		/* block handed to the current read */
+  } buffers[RC_BUFFERS];
+  unsigned char *read_buffer;		/* PL_malloc()'ed rb.base */
+  int		read_buffer_size;	/* rb.size */
+  unsigned int *buckets;		/* PL_malloc()'ed variable hash table */
+  unsigned int	hash_size;		/* #buckets */
+} read_cache;
+
+#define get_read_cache(_) LDFUNC(get_read_cache, _)
+static read_cache *
+get_read_cache(DECL_LD)
+{ if ( !LD->reader.cache )
+    LD->reader.cache = calloc(1, sizeof(read_cache));
+
+  return LD->reader.cache;
+}
+
+/* The statistics keys read_buffers_reused and read_buffers_allocated
+ * count the blocks taken from the cache and the blocks a read had to
+ * allocate or enlarge.
+ */
+
+#define reuse_buffer(b, rc, which) LDFUNC(reuse_buffer, b, rc, which)
+static void
+reuse_buffer(DECL_LD TmpBuffer b, read_cache *rc, int which)
+{ if ( rc && rc->buffers[which].base )
+  { b->base = b->top = rc->buffers[which].base;
+    b->max  = b->base + rc->buffers[which].size;
+    rc->buffers[which].lent = b->base;
+    rc->buffers[which].base = NULL;
+    LD->reader.reused++;
+  } else
+  { initBuffer(b);
+  }
+}
+
+#define release_buffer(b, rc, which) LDFUNC(release_buffer, b, rc, which)
+static void
+release_buffer(DECL_LD TmpBuffer b, read_cache *rc, int which)
+{ if ( b->base != b->static_buffer &&
+       (!rc || b->base != rc->buffers[which].lent) )
+    LD->reader.allocated++;
+
+  if ( rc && !rc->buffers[which].base &&
+       b->base != b->static_buffer &&
+       b->max - b->base <= READ_CACHE_MAX )
+  { rc->buffers[which].base = b->base;
+    rc->buffers[which].size = b->max - b->base;
+  } else
+  { discardBuffer(b);
+  }
+}
+
+void
+freeReadCache(PL_local_data_t *ld)
+{ read_cache *rc = ld->reader.cache;
+
+  if ( rc )
+  { ld->reader.cache = NULL;
+
+    for(int i=0; i<RC_BUFFERS; i++)
+    { if ( rc->buffers[i].base )
+	tmp_free(rc->buffers[i].base);
+    }
+    if ( rc->read_buffer )
+      PL_free(rc->read_buffer);
+    if ( rc->buckets )
+      PL_free(rc->buckets);
+    free(rc);
+  }
+}
+
+
 #define init_read_data(_PL_rd, in) LDFUNC(init_read_data, _PL_rd, in)
 static void
 init_read_data(DECL_LD ReadData _PL_rd, IOSTREAM *in)
-{ memset(_PL_rd, 0, offsetof(read_data, _rb.fast));
+{ read_cache *rc = get_read_cache();
+
+  memset(_PL_rd, 0, offsetof(read_data, _rb.fast));
 
-  initBuffer(&var_name_buffer);
-  initBuffer(&var_buffer);
-  initBuffer(&_PL_rd->op.out_queue);
-  initBuffer(&_PL_rd->op.side_queue);
+  reuse_buffer(&var_name_buffer, rc, RC_VAR_NAMES);
+  reuse_buffer(&var_buffer, rc, RC_VARS);
+  reuse_buffer(&_PL_rd->op.out_queue, rc, RC_OUT_QUEUE);
+  reuse_buffer(&_PL_rd->op.side_queue, rc, RC_SIDE_QUEUE);
   var_hash_size = 0;
   init_term_stack(_PL_rd);
+  if ( rc && rc->read_buffer )
+  { rb.base = rc->read_buffer;
+    rb.size = rc->read_buffer_size;
+    rc->read_buffer = NULL;
+    LD->reader.reused++;
+  }
   _PL_rd->exception = PL_new_term_ref();
   rb.stream = in;
   _PL_rd->magic = RD_MAGIC;
@@ -528,18 +634,32 @@ init_read_data(DECL_LD ReadData _PL_rd, IOSTREAM *in)
 
 static void
 free_read_data(ReadData _PL_rd)
-{ if ( rdbase && rdbase != rb.fast )
-    PL_free(rdbase);
+{ GET_LD
+  read_cache *rc = LD->reader.cache;
+
+  if ( rb.base && rb.base != rb.fast )
+  { if ( rc && !rc->read_buffer && rb.size <= READ_CACHE_MAX )
+    { rc->read_buffer = rb.base;
+      rc->read_buffer_size = rb.size;
+    } else
+      PL_free(rb.base);
+  }
 
   if ( _PL_rd->locked )
     PL_unregister_atom(_PL_rd->locked);
 
-  discardBuffer(&var_name_buffer);
-  discardBuffer(&var_buffer);
-  discardBuffer(&_PL_rd->op.out_queue);
-  discardBuffer(&_PL_rd->op.side_queue);
+  release_buffer(&var_name_buffer, rc, RC_VAR_NAMES);
+  release_buffer(&var_buffer, rc, RC_VARS);
+  release_buffer(&_PL_rd->op.out_queue, rc, RC_OUT_QUEUE);
+  release_buffer(&_PL_rd->op.side_queue, rc, RC_SIDE_QUEUE);
   if ( var_hash_size )
-    PL_free(var_buckets);
+  { if ( rc && !rc->buckets &&
+	 var_hash_size*sizeof(*var_buckets) <= READ_CACHE_MAX )
+    { rc->buckets = var_buckets;
+      rc->hash_size = var_hash_size;
+    } else
+      PL_free(var_buckets);
+  }
   clear_term_stack(_PL_rd);
 }
 
@@ -907,7 +1027,10 @@ clearBuffer(ReadData _PL_rd)
 
 static void
 growToBuffer(int c, ReadData _PL_rd)
-{ if ( rb.base == rb.fast )		/* long clause: jump to use malloc() */
+{ GET_LD
+
+  LD->reader.allocated++;
+  if ( rb.base == rb.fast )		/* long clause: jump to use malloc() */
   { rb.base = PL_malloc_atomic(FASTBUFFERSIZE * 2);
     memcpy(rb.base, rb.fast, FASTBUFFERSIZE);
   } else
@@ -1631,10 +1754,24 @@ linkVariable(Variable var, ReadData _PL_rd)
 static int
 rehashVariables(ReadData _PL_rd)
 { if ( !var_hash_size )
-  { var_hash_size = 32;
-    var_buckets = PL_malloc(var_hash_size*sizeof(*var_buckets));
+  { GET_LD
+    read_cache *rc = LD->reader.cache;
+
+    if ( rc && rc->buckets )
+    { var_hash_size = rc->hash_size;
+      var_buckets = rc->buckets;
+      rc->buckets = NULL;
+      LD->reader.reused++;
+    } else
+    { var_hash_size = 32;
+      var_buckets = PL_malloc(var_hash_size*sizeof(*var_buckets));
+      LD->reader.allocated++;
+    }
   } else
-  { var_hash_size *= 2;
+  { GET_LD
+
+    LD->reader.allocated++;
+    var_hash_size *= 2;
     var_buckets = PL_realloc(var_buckets, var_hash_size*sizeof(*var_buckets));
   }
 
@@ -2714,6 +2851,9 @@ ascii_to_double(cucharp s, cucharp e, double *dp)
 { char *es;
   double d;
 
+  if ( strtod_fast((const char*)s, (const char*)e, dp) )
+    return NUM_OK;
+
   errno = 0;
   d = strtod((char*)s, &es);
   if ( (cucharp)es == e || (e[0] == '.' && e+1 == (cucharp)es) )
@@ -3274,7 +3414,10 @@ alloc_term() allocates a new term in the
 
 static void
 init_term_stack(ReadData _PL_rd)
-{ initBuffer(&_PL_rd->term_stack.terms);
+{ GET_LD
+
+  reuse_buffer(&_PL_rd->term_stack.terms,
+	       LD->reader.cache, RC_TERM_STACK);
   _PL_rd->term_stack.allocated = 0;
   _PL_rd->term_stack.top = 0;
 }
@@ -3282,7 +3425,10 @@ init_term_stack(ReadData _PL_rd)
 
 static void
 clear_term_stack(ReadData _PL_rd)
-{ discardBuffer(&_PL_rd->term_stack.terms);
+{ GET_LD
+
+  release_buffer(&_PL_rd->term_stack.terms,
+		 LD->reader.cache, RC_TERM_STACK);
 }
 
 
@@ -3705,6 +3851,9 @@ simple_term() which reads everything, except for operators.
 
 #define simple_term(token, positions, _PL_rd) LDFUNC(simple_term, token, positions, _PL_rd)
 static int simple_term(DECL_LD Token token, term_t positions, ReadData _PL_rd);
+#define data_term(stop, positions, _PL_rd) \
+	LDFUNC(data_term, stop, positions, _PL_rd)
+static int data_term(DECL_LD const char *stop, term_t positions, ReadData _PL_rd);
 
 typedef struct cterm_state
 { ReadData	rd;			/* Read global data */
@@ -4116,6 +4265,9 @@ complex_term(DECL_LD const char *stop, short maxpri, term_t positions,
     .rmo = 0
   };
 
+  if ( _PL_rd->data )
+    return data_term(stop, positions, _PL_rd);
+
   if ( _PL_rd->strictness == 0 )
     maxpri = OP_MAXPRIORITY+1;
   end_op.left_pri = maxpri;
@@ -4291,6 +4443,55 @@ exit:
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+data_term() replaces complex_term() if read_term/2,3 is called with the
+option syntax(data). It reads a term that  does not use operators, i.e.,
+numbers, atoms, strings, variables, lists, {}/1 terms and compounds in
+canonical f(...) notation. As  operators   need  not be resolved, every
+term is a single simple_term(), which avoids   the operator lookup for
+each name as well as  the  out  and   side  queues.  Sub-terms of lists,
+compounds, etc. are read through complex_term()  and thus recursively by
+data_term().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+data_term(DECL_LD const char *stop, term_t positions, ReadData _PL_rd)
+{ Token token;
+  int rc;
+
+  if ( !(token = get_token(false, _PL_rd)) )
+    return false;
+  if ( token->type == T_PUNCTUATION && !strchr("([{", token->value.character) )
+    syntaxError("cannot_start_term", _PL_rd);
+  if ( (rc=simple_term(token, positions, _PL_rd)) != true )
+    return rc;
+
+  if ( !(token = get_token(false, _PL_rd)) )
+    return false;
+  switch(token->type)
+  { case T_FULLSTOP:
+      if ( stop == NULL )
+	goto exit;
+      break;
+    case T_PUNCTUATION:
+      if ( stop != NULL && strchr(stop, token->value.character) )
+	goto exit;
+      break;
+#ifdef O_QUASIQUOTATIONS
+    case T_QQ_BAR:
+      if ( stop != NULL && stop[0] == '|' )
+	goto exit;
+      break;
+#endif
+  }
+  syntaxError("operator_expected", _PL_rd);
+
+exit:
+  unget_token();
+  return true;
+}
+
+
 #define set_range_position(positions, start, end) LDFUNC(set_range_position, positions, start, end)
 static void
 set_range_position(DECL_LD term_t positions, int64_t start, int64_t end)
@@ -5230,7 +5431,8 @@ retry:
 			&process_comment,
 			&opt_comments,
 			&syntax_errors) )
-  { PL_close_foreign_frame(fid);
+  { free_read_data(&rd);
+    PL_close_foreign_frame(fid);
     return false;
   }
 
@@ -5306,6 +5508,7 @@ static const PL_option_t read_term_options[] =
 #endif
   { ATOM_cycles,	    OPT_BOOL },
   { ATOM_dotlists,	    OPT_BOOL },
+  { ATOM_syntax,	    OPT_ATOM },
   { NULL_ATOM,		    0 }
 };
 
@@ -5323,6 +5526,7 @@ read_term_from_stream(DECL_LD IOSTREAM *s, term_t term, term_t options)
   atom_t dq = NULL_ATOM;
   atom_t bq = NULL_ATOM;
   atom_t mname = NULL_ATOM;
+  atom_t syntax = NULL_ATOM;
   fid_t fid = PL_open_foreign_frame();
 
 retry:
@@ -5349,8 +5553,11 @@ retry:
 			&tcomments,
 			QQ_ARG
 			&rd.cycles,
-			&rd.dotlists) )
-    return false;
+			&rd.dotlists,
+			&syntax) )
+  { rval = false;
+    goto out;
+  }
 
   if ( mname )
   { rd.module = isCurrentModule(mname);
@@ -5371,13 +5578,24 @@ retry:
     else
       clear(&rd, M_VARPREFIX);
   }
-  if ( dq )
-  { if ( !setDoubleQuotes(dq, &rd.flags) )
-      return false;
+  if ( dq && !setDoubleQuotes(dq, &rd.flags) )
+  { rval = false;
+    goto out;
   }
-  if ( bq )
-  { if ( !setBackQuotes(bq, &rd.flags) )
-      return false;
+  if ( bq && !setBackQuotes(bq, &rd.flags) )
+  { rval = false;
+    goto out;
+  }
+  if ( syntax && syntax != ATOM_standard )
+  { if ( syntax == ATOM_data )
+    { rd.data = true;
+    } else
+    { term_t value = PL_new_term_ref();
+
+      PL_put_atom(value, syntax);
+      rval = PL_error(NULL, 0, NULL, ERR_DOMAIN, ATOM_syntax, value);
+      goto out;
+    }
   }
   if ( rd.singles && PL_get_atom(rd.singles, &w) && w == ATOM_warning )
     rd.singles = true;
@@ -5388,7 +5606,9 @@ retry:
 
   rval = read_term(term, &rd);
   if ( Sferror(s) )
-    return false;
+  { rval = false;
+    goto out;
+  }
 
   if ( rval )
   { if ( tpos )
@@ -5405,6 +5625,7 @@ retry:
     }
   }
 
+out:
   free_read_data(&rd);
 
   return rval;
@@ -5537,7 +5758,10 @@ atom_to_term(DECL_LD term_t atom, term_t term, term_t bindings, int text_type)
     if ( bindings && (PL_is_variable(bindings) || PL_is_list(bindings)) )
       rd.varnames = bindings;
     else if ( bindings )
+    { free_read_data(&rd);
+      Sclose(stream);
       return PL_error(NULL, 0, NULL, ERR_TYPE, ATOM_list, bindings);
+    }
     set(&rd, M_RDSTRING_TERM);
 
     if ( !(rval = read_term(term, &rd)) && rd.has_exception )
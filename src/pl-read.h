@@ -78,5 +78,6 @@ int		read_clause(IOSTREAM *s, term_t term, term_t options);
 #undef LDFUNC_DECLARATIONS
 
 const char *	utf8_skip_blanks(const char *in);
+void		freeReadCache(PL_local_data_t *ld);
 
 #endif /*_PL_READ_H*/
@@ -44,6 +44,7 @@
 #include "os/pl-cstack.h"
 #include "os/pl-ctype.h"
 #include "os/pl-prologflag.h"
+#include "os/pl-fmt.h"
 #include "pl-dbref.h"
 #include "pl-trie.h"
 #include "pl-tabling.h"
@@ -1797,6 +1798,8 @@ freePrologLocalData(PL_local_data_t *ld)
   clearThreadTablingData(ld);
   if ( ld->tabling.node_pool )
     free_alloc_pool(ld->tabling.node_pool);
+  if ( ld->tabling.idg_batch.pending )
+    destroyHTable(ld->tabling.idg_batch.pending);
 
 #ifdef O_C_STACK_GUARDED
   if ( ld->signal.alt_stack )
@@ -1808,6 +1811,8 @@ freePrologLocalData(PL_local_data_t *ld)
 #endif
 
   free_undo_data(ld);
+  freeFormatCache(ld);
+  freeReadCache(ld);
 
   if ( ld->btrace_store )
   { btrace_destroy(ld->btrace_store);
@@ -40,6 +40,10 @@
 #include "os/pl-ctype.h"
 #include "os/pl-utf8.h"
 #include "pl-inline.h"
+#include "pl-read.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #undef LD
 #define LD LOCAL_LD
@@ -362,6 +366,101 @@ PRED_IMPL("get_string_code", 3, get_string_code, 0)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Character sets for split_string/4.  Membership of characters below 256
+is a bitmap test; larger characters use text_chr() on the original set.
+find_char_set() finds the next member in the input. If the input is ISO
+Latin-1 it uses memchr() for a single member and SSE2 to compare 16
+bytes at a time against up to CHAR_SET_SCAN_MAX members.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define CHAR_SET_SCAN_MAX 4
+
+typedef struct char_set
+{ uint64_t	bits[4];		/* members 0..255 */
+  const PL_chars_t *text;		/* the set as text */
+  bool		wide;			/* has members > 255 */
+  int		count;			/* # distinct members < 256 */
+  unsigned char	scan[CHAR_SET_SCAN_MAX]; /* first members < 256 */
+} char_set;
+
+static void
+init_char_set(char_set *cs, const PL_chars_t *set)
+{ memset(cs, 0, sizeof(*cs));
+  cs->text = set;
+
+  for(size_t i=0; i<set->length; i++)
+  { int c = text_get_char(set, i);
+
+    if ( c < 256 )
+    { uint64_t bit = (uint64_t)1<<(c&63);
+
+      if ( !(cs->bits[c>>6] & bit) )
+      { cs->bits[c>>6] |= bit;
+	if ( cs->count < CHAR_SET_SCAN_MAX )
+	  cs->scan[cs->count] = (unsigned char)c;
+	cs->count++;
+      }
+    } else
+    { cs->wide = true;
+    }
+  }
+}
+
+static inline bool
+in_char_set(const char_set *cs, int c)
+{ if ( c < 256 )
+    return (cs->bits[c>>6] >> (c&63)) & 1;
+
+  return cs->wide && text_chr(cs->text, c) != (size_t)-1;
+}
+
+static size_t
+find_char_set(const PL_chars_t *t, size_t i, size_t end, const char_set *cs)
+{ if ( t->encoding == ENC_ISO_LATIN_1 )
+  { const unsigned char *s = (const unsigned char *)t->text.t;
+
+    if ( cs->count == 0 || i >= end )
+      return end;
+    if ( cs->count == 1 )
+    { const unsigned char *p = memchr(s+i, cs->scan[0], end-i);
+
+      return p ? (size_t)(p-s) : end;
+    }
+#ifdef __SSE2__
+    if ( cs->count <= CHAR_SET_SCAN_MAX )
+    { __m128i m[CHAR_SET_SCAN_MAX];
+
+      for(int k=0; k<cs->count; k++)
+	m[k] = _mm_set1_epi8((char)cs->scan[k]);
+
+      for( ; i+16 <= end; i += 16 )
+      { __m128i v = _mm_loadu_si128((const __m128i*)(s+i));
+	__m128i r = _mm_cmpeq_epi8(v, m[0]);
+	int mask;
+
+	for(int k=1; k<cs->count; k++)
+	  r = _mm_or_si128(r, _mm_cmpeq_epi8(v, m[k]));
+	if ( (mask = _mm_movemask_epi8(r)) )
+	  return i + __builtin_ctz(mask);
+      }
+    }
+#endif
+    for( ; i<end; i++ )
+    { if ( (cs->bits[s[i]>>6] >> (s[i]&63)) & 1 )
+	return i;
+    }
+    return end;
+  }
+
+  for( ; i<end; i++ )
+  { if ( in_char_set(cs, text_get_char(t, i)) )
+      return i;
+  }
+  return end;
+}
+
+
 /** split_string(+String, +SepChars, +PadChars, -SubStrings) is det.
 */
 
@@ -384,18 +483,21 @@ PRED_IMPL("split_string", 4, split_string, 0)
     term_t head = PL_new_term_ref();
     size_t sep_at = (size_t)-1;
     size_t end;
+    char_set seps, pads;
 
+    init_char_set(&seps, &sep);
+    init_char_set(&pads, &pad);
 						/* back skip padding at end */
     for(end=input.length;
 	end > 0 &&
-	text_chr(&pad, text_get_char(&input, end-1)) != (size_t)-1;
+	in_char_set(&pads, text_get_char(&input, end-1));
 	end--)
       ;
 
     for(i=0;;)
     {					/* skip padding */
       while( i<end &&
-	     text_chr(&pad, text_get_char(&input, i)) != (size_t)-1 )
+	     in_char_set(&pads, text_get_char(&input, i)) )
 	i++;
 
       if ( i == end )
@@ -407,12 +509,10 @@ PRED_IMPL("split_string", 4, split_string, 0)
 
     no_skip_padding:
       last = i;				/* find sep */
-      while( i<end &&
-	     text_chr(&sep, text_get_char(&input, i)) == (size_t)-1 )
-	i++;
+      i = find_char_set(&input, i, end, &seps);
       sep_at = i;			/* back skip padding */
       while( i>last &&
-	     text_chr(&pad, text_get_char(&input, i-1)) != (size_t)-1 )
+	     in_char_set(&pads, text_get_char(&input, i-1)) )
 	i--;
 
       if ( !PL_unify_list_ex(tail, head, tail) ||
@@ -424,8 +524,8 @@ PRED_IMPL("split_string", 4, split_string, 0)
 
       i = sep_at+1;
 
-      if ( text_chr(&pad, text_get_char(&input, sep_at)) == (size_t)-1 &&
-	   text_chr(&sep, text_get_char(&input, sep_at+1)) != (size_t)-1 )
+      if ( !in_char_set(&pads, text_get_char(&input, sep_at)) &&
+	   in_char_set(&seps, text_get_char(&input, sep_at+1)) )
 	goto no_skip_padding;
     }
 
@@ -478,17 +578,32 @@ PRED_IMPL("read_string", 5, read_string, 0)
        PL_get_text(A2, &sep, flags) &&
        PL_get_text(A3, &pad, flags) )
   { int chr;
+    char stop[128];
+    size_t i;
+
+    memset(stop, 0, sizeof(stop));
+    for(i=0; i<sep.length; i++)
+    { int c = text_get_char(&sep, i);
+
+      if ( c < 128 )
+	stop[c] = true;
+    }
 
     do
     { chr = Sgetcode(s);
     } while(chr != EOF && text_chr(&pad, chr) != (size_t)-1);
 
     for(;;)
-    { if ( chr == EOF && Sferror(s) )
+    { const char *span;
+      size_t n;
+
+      if ( chr == EOF && Sferror(s) )
 	goto out;
       if ( chr == EOF || text_chr(&sep, chr) != (size_t)-1 )
 	break;
       addUTF8Buffer((Buffer)&tmpbuf, chr);
+      while( (n=Sfetch_ascii(s, stop, (size_t)-1, &span)) > 0 )
+	addMultipleBuffer((Buffer)&tmpbuf, span, n, char);
       chr = Sgetcode(s);
     }
 
@@ -537,8 +652,17 @@ PRED_IMPL("read_string", 3, read_string, 0)
   { size_t count;
 
     for(count=0; count < len; count++)
-    { int chr = Sgetcode(s);
-      if ( chr == EOF )
+    { const char *span;
+      size_t n;
+      int chr;
+
+      if ( (n=Sfetch_ascii(s, NULL, len-count, &span)) > 0 )
+      { addMultipleBuffer((Buffer)&tmpbuf, span, n, char);
+	count += n-1;
+	continue;
+      }
+
+      if ( (chr = Sgetcode(s)) == EOF )
       { if ( Sferror(s) )
 	  goto out;
 	break;
@@ -565,6 +689,115 @@ out:
   return rc;
 }
 
+/** read_lines(+Stream, -Lines, +Options)
+ *
+ * Read lines (or records terminated by  separator(Char)) from Stream into
+ * a list of strings, atoms, code lists or char lists.  Runs of ASCII text
+ * are copied from the stream buffer without decoding.
+*/
+
+static const PL_option_t read_lines_options[] =
+{ { ATOM_max_count,	OPT_SIZE|OPT_INF },
+  { ATOM_as,		OPT_ATOM },
+  { ATOM_separator,	OPT_TERM },
+  { NULL_ATOM,		0 }
+};
+
+static
+PRED_IMPL("read_lines", 3, read_lines, 0)
+{ PRED_LD
+  IOSTREAM *s = NULL;
+  size_t max_count = (size_t)-1;
+  atom_t as = ATOM_string;
+  term_t separator = 0;
+  int sep = '\n';
+  int type;
+  int rc = false;
+  tmp_buffer tmpbuf;
+
+  if ( !PL_scan_options(A3, 0, "read_lines_option", read_lines_options,
+			&max_count, &as, &separator) )
+    return false;
+  if ( separator && !PL_get_char_ex(separator, &sep, false) )
+    return false;
+
+  if ( as == ATOM_string )
+    type = PL_STRING;
+  else if ( as == ATOM_atom )
+    type = PL_ATOM;
+  else if ( as == ATOM_codes )
+    type = PL_CODE_LIST;
+  else if ( as == ATOM_chars )
+    type = PL_CHAR_LIST;
+  else
+  { term_t ex;
+
+    return ( (ex=PL_new_term_ref()) &&
+	     PL_put_atom(ex, as) &&
+	     PL_domain_error("text_type", ex) );
+  }
+
+  initBuffer(&tmpbuf);
+  if ( getTextInputStream(A1, &s) )
+  { term_t tail = PL_copy_term_ref(A2);
+    term_t head = PL_new_term_ref();
+    size_t count;
+
+    for(count=0; count < max_count; count++)
+    { int chr;
+
+      emptyBuffer(&tmpbuf, 1024);
+      for(;;)
+      { const char *span;
+	size_t n;
+
+	if ( sep < 128 )
+	{ while( (n=Sfetch_ascii_to(s, sep, (size_t)-1, &span)) > 0 )
+	    addMultipleBuffer((Buffer)&tmpbuf, span, n, char);
+	} else
+	{ while( (n=Sfetch_ascii(s, NULL, (size_t)-1, &span)) > 0 )
+	    addMultipleBuffer((Buffer)&tmpbuf, span, n, char);
+	}
+	if ( (chr = Sgetcode(s)) == EOF || chr == sep )
+	  break;
+	addUTF8Buffer((Buffer)&tmpbuf, chr);
+      }
+
+      if ( chr == EOF )
+      { if ( Sferror(s) )
+	  goto out;
+	if ( entriesBuffer(&tmpbuf, char) == 0 )
+	  break;
+      }
+      if ( sep == '\n' && entriesBuffer(&tmpbuf, char) > 0 &&
+	   topBuffer(&tmpbuf, char)[-1] == '\r' )
+	tmpbuf.top--;
+
+      if ( !PL_unify_list_ex(tail, head, tail) ||
+	   !PL_unify_chars(head, type|REP_UTF8,
+			   entriesBuffer(&tmpbuf, char),
+			   baseBuffer(&tmpbuf, char)) )
+	goto out;
+      if ( chr == EOF )
+	break;
+    }
+
+    rc = PL_unify_nil_ex(tail);
+  }
+
+out:
+  discardBuffer(&tmpbuf);
+  if ( s )
+  { if ( rc )
+      rc = PL_release_stream(s);
+    else
+      PL_release_stream(s);
+  }
+
+  return rc;
+}
+
+
 /** open_string(+String, -Stream)
  *
  * Open a string as a stream.
@@ -600,6 +833,219 @@ PRED_IMPL("open_string", 2, open_string, 0)
 }
 
 
+		 /*******************************
+		 *	       CSV		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+'$csv_read_row'(+Stream, -Row, +Functor, +Separator, +Flags) reads a
+single CSV record from Stream for library(csv).  The record is parsed as
+the csv//2 grammar does: a field that starts with a double quote extends
+to the matching quote, where a doubled quote denotes a quote; other
+fields extend to the separator or end of the line.  Runs of plain ASCII
+are copied from the stream buffer using Sfetch_ascii().  Row is unified
+with end_of_file if the stream is at its end and the predicate fails on
+a malformed or unterminated quoted field.  Flags is a bitwise or of the
+CSV_* flags below.  CSV_LINES is used by csv_read_row/3 and maps \r\n
+inside a quoted field to \n, as read_line_to_codes/2 used to do.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define CSV_STRIP		0x01	/* strip(true) */
+#define CSV_IGNORE_QUOTES	0x02	/* ignore_quotes(true) */
+#define CSV_CONVERT		0x04	/* convert(true) */
+#define CSV_DOWNCASE		0x08	/* case(down) */
+#define CSV_UPCASE		0x10	/* case(up) */
+#define CSV_STRINGS		0x20	/* field_type(string) */
+#define CSV_LINES		0x40	/* map \r\n in quoted fields to \n */
+
+#define csv_field_value(t, b, flags) LDFUNC(csv_field_value, t, b, flags)
+
+static int
+csv_field_value(DECL_LD term_t t, Buffer b, int flags)
+{ size_t len = entriesBuffer(b, char);
+  char *s = baseBuffer(b, char);
+  int type = ((flags&CSV_STRINGS) ? PL_STRING : PL_ATOM)|REP_UTF8;
+
+  if ( (flags&CSV_CONVERT) && len > 0 &&
+       (isDigit(s[0]&0xff) || s[0] == '-' || s[0] == '+') )
+  { number n;
+    unsigned char *end;
+    strnumstat rc;
+
+    addBuffer(b, EOS, char);		/* str_number() needs a 0-byte */
+    s = baseBuffer(b, char);
+    rc = str_number((const unsigned char *)s, &end, &n, 0);
+    (void)popBuffer(b, char);
+    if ( rc == NUM_OK )
+    { if ( (char*)end == s+len )
+      { int ok = PL_unify_number(t, &n);
+
+	clearNumber(&n);
+	return ok;
+      }
+      clearNumber(&n);
+    }
+  }
+
+  if ( (flags&(CSV_DOWNCASE|CSV_UPCASE)) )
+  { tmp_buffer cb;
+    const char *e = s+len;
+    int ok;
+
+    initBuffer(&cb);
+    while(s < e)
+    { int c;
+
+      s = utf8_get_char(s, &c);
+      addUTF8Buffer((Buffer)&cb, (flags&CSV_DOWNCASE) ? ftolower(c)
+						      : ftoupper(c));
+    }
+    ok = PL_unify_chars(t, type,
+			entriesBuffer(&cb, char), baseBuffer(&cb, char));
+    discardBuffer(&cb);
+
+    return ok;
+  }
+
+  return PL_unify_chars(t, type, len, s);
+}
+
+
+static int
+is_csv_blank(int c)
+{ return c == ' ' || c == '\t';
+}
+
+
+static
+PRED_IMPL("$csv_read_row", 5, csv_read_row, 0)
+{ PRED_LD
+  IOSTREAM *s = NULL;
+  atom_t name;
+  int sep, flags;
+  int rc = false;
+  tmp_buffer tmpbuf;
+  tmp_buffer fields;
+
+  if ( !PL_get_atom_ex(A3, &name) ||
+       !PL_get_char_ex(A4, &sep, false) ||
+       !PL_get_integer_ex(A5, &flags) )
+    return false;
+
+  initBuffer(&tmpbuf);
+  initBuffer(&fields);
+  if ( getTextInputStream(A1, &s) )
+  { char field_stop[128];		/* ends an unquoted field */
+    char quote_stop[128];		/* ends a run in a quoted field */
+    size_t arity, i;
+    functor_t f;
+    int chr;
+
+    memset(field_stop, 0, sizeof(field_stop));
+    field_stop['\n'] = field_stop['\r'] = true;
+    if ( sep < 128 )
+      field_stop[sep] = true;
+    memset(quote_stop, 0, sizeof(quote_stop));
+    quote_stop['"'] = quote_stop['\r'] = true;
+
+    if ( (chr=Sgetcode(s)) == EOF )
+    { if ( !Sferror(s) )
+	rc = PL_unify_atom(A2, ATOM_end_of_file);
+      goto out;
+    }
+
+    for(;;)
+    { term_t value;
+      const char *span;
+      size_t n;
+
+      emptyBuffer(&tmpbuf, 1024);
+      if ( chr == '"' && !(flags&CSV_IGNORE_QUOTES) )
+      { for(;;)
+	{ while( (n=Sfetch_ascii(s, quote_stop, (size_t)-1, &span)) > 0 )
+	    addMultipleBuffer((Buffer)&tmpbuf, span, n, char);
+	  if ( (chr=Sgetcode(s)) == EOF )
+	    goto out;			/* unterminated quoted field */
+	  if ( chr == '"' )
+	  { if ( Speekcode(s) != '"' )
+	      break;
+	    Sgetcode(s);
+	  } else if ( chr == '\r' && (flags&CSV_LINES) && Speekcode(s) == '\n' )
+	  { continue;
+	  }
+	  addUTF8Buffer((Buffer)&tmpbuf, chr);
+	}
+	chr = Sgetcode(s);
+      } else
+      { if ( (flags&CSV_STRIP) )
+	{ while( is_csv_blank(chr) )
+	    chr = Sgetcode(s);
+	}
+	while( chr != EOF && chr != sep && chr != '\n' && chr != '\r' )
+	{ addUTF8Buffer((Buffer)&tmpbuf, chr);
+	  while( (n=Sfetch_ascii(s, field_stop, (size_t)-1, &span)) > 0 )
+	    addMultipleBuffer((Buffer)&tmpbuf, span, n, char);
+	  chr = Sgetcode(s);
+	}
+	if ( (flags&CSV_STRIP) )
+	{ while( entriesBuffer(&tmpbuf, char) > 0 &&
+		 is_csv_blank(topBuffer(&tmpbuf, char)[-1]) )
+	    (void)popBuffer(&tmpbuf, char);
+	}
+      }
+
+      if ( !(value = PL_new_term_ref()) ||
+	   !csv_field_value(value, (Buffer)&tmpbuf, flags) )
+	goto out;
+      addBuffer(&fields, value, term_t);
+
+      if ( chr == sep )
+      { chr = Sgetcode(s);
+	continue;
+      }
+      if ( chr == '\r' )
+      { if ( Speekcode(s) == '\n' )
+	  Sgetcode(s);
+	break;
+      }
+      if ( chr == '\n' )
+	break;
+      if ( chr == EOF )
+      { if ( Sferror(s) )
+	  goto out;
+	break;
+      }
+      goto out;				/* garbage after quoted field */
+    }
+
+    arity = entriesBuffer(&fields, term_t);
+    f = PL_new_functor(name, arity);
+    if ( PL_unify_functor(A2, f) )
+    { term_t a = PL_new_term_ref();
+
+      for(i=0; i<arity; i++)
+      { _PL_get_arg(i+1, A2, a);
+	if ( !PL_unify(a, fetchBuffer(&fields, i, term_t)) )
+	  goto out;
+      }
+      rc = true;
+    }
+  }
+
+out:
+  discardBuffer(&tmpbuf);
+  discardBuffer(&fields);
+  if ( s )
+  { if ( rc )
+      rc = PL_release_stream(s);
+    else
+      PL_release_stream(s);
+  }
+
+  return rc;
+}
+
+
 		 /*******************************
 		 *      PUBLISH PREDICATES	*
 		 *******************************/
@@ -615,5 +1061,7 @@ BeginPredDefs(strings)
   PRED_DEF("get_string_code", 3, get_string_code, 0)
   PRED_DEF("read_string",     5, read_string,     0)
   PRED_DEF("read_string",     3, read_string,     0)
+  PRED_DEF("read_lines",      3, read_lines,      0)
   PRED_DEF("open_string",     2, open_string,     0)
+  PRED_DEF("$csv_read_row",   5, csv_read_row,    0)
 EndPredDefs
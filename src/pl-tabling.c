@@ -129,6 +129,7 @@ typedef struct
 #define	mono_queue_answer(atrie, ans, an)		LDFUNC(mono_queue_answer, atrie, ans, an)
 #define	force_reeval(n)					LDFUNC(force_reeval, n)
 #define find_dep(mdep, dep, found)			LDFUNC(find_dep, mdep, dep, found)
+#define idg_batch_reset(atrie)				LDFUNC(idg_batch_reset, atrie)
 #endif /*USE_LD_MACROS*/
 
 #define LDFUNC_DECLARATIONS
@@ -198,6 +199,7 @@ static void	force_reeval(idg_node *n);
 static int	idg_changed(trie *atrie, int flags);
 static trie    *idg_propagate_change(idg_node *n, int flags);
 static int	find_dep(idg_mdep *mdep, term_t dep, idg_mdep **found);
+static void	idg_batch_reset(trie *atrie);
 #undef LDFUNC_DECLARATIONS
 
 #define WL_IS_SPECIAL(wl)  (((intptr_t)(wl)) & 0x1)
@@ -220,6 +222,10 @@ static int	find_dep(idg_mdep *mdep, term_t dep, idg_mdep **found);
 #define IDG_CHANGED_MONO	0x0002		/* Monotonic node change */
 #define IDG_PROPAGATE_FORCE	0x0004		/* See (**) */
 
+#define IDG_BATCH_SYNC() \
+	( LD->tabling.idg_batch.pending && \
+	  LD->tabling.idg_batch.pending->size > 0 ? idg_batch_flush() : true )
+
 #ifdef O_PLMT
 #define	LOCK_SHARED_TABLE(t)	countingMutexLock(&GD->tabling.mutex);
 #define	UNLOCK_SHARED_TABLE(t)	countingMutexUnlock(&GD->tabling.mutex);
@@ -2984,6 +2990,12 @@ complete_worklist(DECL_LD worklist *wl, int destroy)
 
   if ( tt_has_modified_dependencies(atrie) )
     tt_add_table(atrie, TT_TBL_INVALIDATE);
+#ifdef O_TRIE_STATS
+  if ( atrie->stats.eval_start > 0.0 )
+  { atrie->stats.eval_time += WallTime() - atrie->stats.eval_start;
+    atrie->stats.eval_start = 0.0;
+  }
+#endif
 
   if ( destroy )
   { free_worklist(wl);
@@ -3132,6 +3144,8 @@ wkl_add_answer(DECL_LD worklist *wl, trie_node *an)
 { potentially_add_to_global_worklist(wl);
   answer ans = {an};
 
+  TRIE_STAT_INC(wl->table, answers);
+
   if ( !answer_is_conditional(an) )
     wl->has_answers = true;
 
@@ -3415,6 +3429,9 @@ tbl_add_worklist(trie *atrie, tbl_component *scc)
   add_global_worklist(wl);
   add_newly_created_worklist(wl);
   clear(atrie, TRIE_COMPLETE);
+#ifdef O_TRIE_STATS
+  atrie->stats.eval_start = WallTime();
+#endif
 
   return wl;
 }
@@ -3625,6 +3642,7 @@ PRED_IMPL("$tbl_wkl_add_answer", 4, tbl_wkl_add_answer, 0)
 	    }
 	  }
 
+	  TRIE_STAT_INC(wl->table, duplicates);
 	  return false;				/* already in trie */
 	}
 	return PL_permission_error("modify", "trie_key", A2);
@@ -3777,6 +3795,8 @@ add_subsuming_answer(DECL_LD worklist *wl, trie *atrie, trie_node *root, term_t
     } else
     { if ( ison(node, TN_IDG_DELETED) )
 	clear(node, TN_IDG_DELETED);
+      else
+	TRIE_STAT_INC(atrie, duplicates);
 
       if ( wl && answer_is_conditional(node) )
        update_delay_list(wl, node, skel, delays);
@@ -4553,6 +4573,8 @@ tbl_variant_table(DECL_LD term_t closure, term_t variant, term_t Trie,
   atom_t clref = 0;
 
   get_closure_predicate(closure, &def);
+  if ( !IDG_BATCH_SYNC() )
+    return false;
 
   if ( (atrie=get_answer_table(def, variant, ret, &clref, flags)) )
   { if ( !idg_init_variant(atrie, def, variant)  ||
@@ -4568,12 +4590,20 @@ tbl_variant_table(DECL_LD term_t closure, term_t variant, term_t Trie,
 	return false;
     }
 
+    TRIE_STAT_INC(atrie, calls);
     if ( clref )
     { TRIE_STAT_INC(atrie, gen_call);
+      TRIE_STAT_INC(atrie, complete_calls);
       return ( PL_unify_atomic(Trie, clref) &&
 	       PL_unify_atomic(status, ATOM_complete) );
     } else
-    { return ( PL_unify_atomic(Trie, atrie->symbol) &&
+    {
+#ifdef O_TRIE_STATS
+      if ( ison(atrie, TRIE_COMPLETE) &&
+	   complete_or_invalid_status(atrie, true) == ATOM_complete )
+	TRIE_STAT_INC(atrie, complete_calls);
+#endif
+      return ( PL_unify_atomic(Trie, atrie->symbol) &&
 	       unify_table_status(status, atrie, def, true) );
     }
   }
@@ -4624,6 +4654,8 @@ PRED_IMPL("$tbl_existing_variant_table", 5, tbl_existing_variant_table, 0)
   atom_t clref = 0;
 
   get_closure_predicate(A1, &def);
+  if ( !IDG_BATCH_SYNC() )
+    return false;
 
   if ( (trie=get_answer_table(def, A2, A5, &clref, false)) )
   { return ( PL_unify_atomic(A3, trie->symbol) &&
@@ -4712,7 +4744,8 @@ PRED_IMPL("$tbl_table_status", 2, tbl_table_status, 0)
 { PRED_LD
   trie *trie;
 
-  return ( get_trie(A1, &trie) &&
+  return ( IDG_BATCH_SYNC() &&
+	   get_trie(A1, &trie) &&
 	   unify_table_status(A2, trie, NULL, false)
 	 );
 }
@@ -4729,7 +4762,8 @@ PRED_IMPL("$tbl_table_status", 4, tbl_table_status, 0)
   trie *trie;
   term_t wv = PL_new_term_ref();
 
-  return ( get_trie(A1, &trie) &&
+  return ( IDG_BATCH_SYNC() &&
+	   get_trie(A1, &trie) &&
 	   unify_table_status(A2, trie, NULL, false) &&
 	   unify_skeleton(trie, wv, A4) &&
 	   PL_unify(A3, wv)
@@ -6525,6 +6559,7 @@ trie_for_dynamic_predicate(DECL_LD Definition def, trie *ctrie, term_t variant)
     }
 
     atrie->data.IDG->falsecount = 0;	/* see (*) above */
+    idg_batch_reset(atrie);
 
     return atrie;
   }
@@ -7170,22 +7205,186 @@ idg_changed(trie *atrie, int flags)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Batched invalidation. Inside a transaction  or '$idg_batch_start'/1, the
+'$idg_changed'/1 calls  from  the  dynamic   predicate  update  hooks do
+not propagate immediately. Instead,   the changed node is  recorded in
+LD->tabling.idg_batch.pending,  such that  many  updates to  the  same
+dynamic node cause a single  IDG traversal  when the batch is flushed.
+The batch is flushed at the end of  the  outermost  batch, before we
+access a table (IDG_BATCH_SYNC()) and when the thread exits, so tabled
+calls inside the batch see the same IDG state as without batching.
+
+Note that a repeated change to a  node  whose  dependents  are already
+invalidated does not propagate without batching either.  It only causes
+a second propagation if the  dynamic  node  was  called  from a tabled
+evaluation in between,  which  resets   its  `falsecount`  (see
+'$idg_add_dyncall'/1).   The  value   of   a   pending   entry  is
+IDG_BATCH_RESET if this happened  since  the  change  was  recorded and
+only such repeated changes are counted as `coalesced`.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define IDG_BATCH_PENDING	((table_value_t)1)
+#define IDG_BATCH_RESET		((table_value_t)2)
+
+static void
+idg_batch_free_symbol(table_key_t k, table_value_t v)
+{ atom_t symbol = (atom_t)k;
+  (void)v;
+
+  PL_unregister_atom(symbol);
+}
+
+
+#define idg_batch_add(atrie) LDFUNC(idg_batch_add, atrie)
+static void
+idg_batch_add(DECL_LD trie *atrie)
+{ Table pending;
+  atom_t symbol = trie_symbol(atrie);
+
+  if ( !(pending=LD->tabling.idg_batch.pending) )
+  { pending = newHTable(16);
+    pending->free_symbol = idg_batch_free_symbol;
+    LD->tabling.idg_batch.pending = pending;
+  }
+
+  switch( lookupHTable(pending, (table_key_t)symbol) )
+  { case 0:
+      addNewHTable(pending, (table_key_t)symbol, IDG_BATCH_PENDING);
+      PL_register_atom(symbol);
+      break;
+    case IDG_BATCH_RESET:
+      updateHTable(pending, (table_key_t)symbol, IDG_BATCH_PENDING);
+      LD->tabling.idg_batch.coalesced++;
+      break;
+  }
+}
+
+
+/* Called if a pending dynamic node is called, resetting its falsecount
+*/
+
+static void
+idg_batch_reset(DECL_LD trie *atrie)
+{ Table pending;
+  atom_t symbol;
+
+  if ( (pending=LD->tabling.idg_batch.pending) && pending->size > 0 &&
+       (symbol=atrie->symbol) &&
+       lookupHTable(pending, (table_key_t)symbol) == IDG_BATCH_PENDING )
+    updateHTable(pending, (table_key_t)symbol, IDG_BATCH_RESET);
+}
+
+
+int
+idg_batch_flush(DECL_LD)
+{ Table pending;
+  int rc = true;
+
+  if ( (pending=LD->tabling.idg_batch.pending) && pending->size > 0 )
+  { DEBUG(MSG_TABLING_IDG_CHANGED,
+	  Sdprintf("IDG: flushing %d batched changes\n", pending->size));
+
+    FOR_TABLE(pending, k, v)
+    { trie *atrie;
+      (void)v;
+
+      if ( (atrie=symbol_trie((atom_t)k)) &&
+	   !idg_changed(atrie, IDG_CHANGED_NODE) )
+	rc = false;
+    }
+    clearHTable(pending);
+  }
+
+  return rc;
+}
+
+
+void
+idg_batch_begin(DECL_LD)
+{ LD->tabling.idg_batch.depth++;
+}
+
+
+int
+idg_batch_end(DECL_LD)
+{ assert(LD->tabling.idg_batch.depth > 0);
+
+  if ( --LD->tabling.idg_batch.depth == 0 )
+    return idg_batch_flush();
+
+  return true;
+}
+
+
+/* Called from freePrologThread() if the thread exits inside a batch,
+   so the dependent tables are not left marked as complete.
+*/
+
+int
+idg_batch_exit(DECL_LD)
+{ LD->tabling.idg_batch.depth = 0;
+
+  return idg_batch_flush();
+}
+
+
 static
 PRED_IMPL("$idg_changed", 1, idg_changed, 0)
-{ trie *atrie;
+{ PRED_LD
+  trie *atrie;
 
   if ( get_trie(A1, &atrie) )
+  { LD->tabling.idg_batch.changes++;
+
+    if ( LD->tabling.idg_batch.depth > 0 )
+    { idg_batch_add(atrie);
+      return true;
+    }
+
     return idg_changed(atrie, IDG_CHANGED_NODE);
+  }
 
   return false;
 }
 
 
+/** '$idg_batch_start'(-Old) is det.
+ *  '$idg_batch_end'(+Old) is det.
+ *
+ * Start/end a batch of IDG changes.  '$idg_batch_end'/1 restores the
+ * nesting to Old and, if this ends the outermost batch, propagates
+ * the pending changes.
+ */
+
+static
+PRED_IMPL("$idg_batch_start", 1, idg_batch_start, 0)
+{ PRED_LD
+
+  return PL_unify_integer(A1, LD->tabling.idg_batch.depth++);
+}
+
+static
+PRED_IMPL("$idg_batch_end", 1, idg_batch_end, 0)
+{ PRED_LD
+
+  if ( !PL_get_integer_ex(A1, &LD->tabling.idg_batch.depth) )
+    return false;
+  if ( LD->tabling.idg_batch.depth == 0 )
+    return idg_batch_flush();
+
+  return true;
+}
+
+
 static
 PRED_IMPL("$idg_falsecount", 2, idg_falsecount, 0)
 { PRED_LD
   trie *atrie;
 
+  if ( !IDG_BATCH_SYNC() )
+    return false;
+
   if ( get_trie(A1, &atrie) )
   { idg_node *n;
 
@@ -9444,6 +9643,8 @@ BeginPredDefs(tabling)
   PRED_DEF("$idg_reset_current",        0, idg_reset_current,        0)
   PRED_DEF("$idg_edge",                 3, idg_edge,              NDET)
   PRED_DEF("$idg_changed",              1, idg_changed,              0)
+  PRED_DEF("$idg_batch_start",          1, idg_batch_start,          0)
+  PRED_DEF("$idg_batch_end",            1, idg_batch_end,            0)
   PRED_DEF("$idg_falsecount",           2, idg_falsecount,           0)
   PRED_DEF("$idg_forced",               1, idg_forced,               0)
   PRED_DEF("$idg_set_falsecount",       2, idg_set_falsecount,       0)
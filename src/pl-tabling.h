@@ -301,6 +301,10 @@ typedef struct table_props
 #if USE_LD_MACROS
 #define		transaction_commit_tables(_)		LDFUNC(transaction_commit_tables, _)
 #define		transaction_rollback_tables(_)		LDFUNC(transaction_rollback_tables, _)
+#define		idg_batch_begin(_)			LDFUNC(idg_batch_begin, _)
+#define		idg_batch_end(_)			LDFUNC(idg_batch_end, _)
+#define		idg_batch_flush(_)			LDFUNC(idg_batch_flush, _)
+#define		idg_batch_exit(_)			LDFUNC(idg_batch_exit, _)
 #define		tbl_push_delay(atrie, wrapper, answer)	LDFUNC(tbl_push_delay, atrie, wrapper, answer)
 #define		idg_add_dyncall(def, ctrie, variant)	LDFUNC(idg_add_dyncall, def, ctrie, variant)
 #define		tbl_get_restraint_flag(t, key)		LDFUNC(tbl_get_restraint_flag, t, key)
@@ -312,6 +316,10 @@ typedef struct table_props
 int	transaction_commit_tables(void);
 int	transaction_rollback_tables(void);
 void	merge_tabling_trail(tbl_trail *into, tbl_trail *from);
+void	idg_batch_begin(void);
+int	idg_batch_end(void);
+int	idg_batch_flush(void);
+int	idg_batch_exit(void);
 
 void	clearThreadTablingData(PL_local_data_t *ld);
 term_t	init_delay_list(void);
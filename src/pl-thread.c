@@ -759,6 +759,14 @@ freePrologThread(PL_local_data_t *ld, int after_fork)
 	  PL_clear_exception();
 	}
 	info->in_exit_hooks = false;
+	if ( LD == ld && ld->tabling.idg_batch.pending &&
+	     ld->tabling.idg_batch.pending->size > 0 &&
+	     !idg_batch_exit() && exception_term )
+	{ Sdprintf("Flushing pending IDG changes left an exception\n");
+	  PL_write_term(Serror, exception_term, 1200,
+			PL_WRT_QUOTED|PL_WRT_NEWLINE);
+	  PL_clear_exception();
+	}
 	WITH_LD(ld) endCritical();	/* TBD: exception? */
       }
     } else
@@ -775,6 +783,7 @@ freePrologThread(PL_local_data_t *ld, int after_fork)
   #endif
 
     cleanupLocalDefinitions(ld);
+    releaseOwnedStreams();
 
     DEBUG(MSG_THREAD, Sdprintf("Destroying data\n"));
     ld->magic = 0;
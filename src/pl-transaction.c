@@ -626,7 +626,9 @@ transaction(DECL_LD term_t goal, term_t constraint, term_t lock, int flags)
     LD->transaction.gen_max    = LD->transaction.gen_base+GEN_TRANSACTION_SIZE-6;
     LD->transaction.generation = LD->transaction.gen_base;
     LD->transaction.id         = goal;
+    idg_batch_begin();
     rc = callProlog(NULL, goal, PL_Q_PASS_EXCEPTION, NULL);
+    rc = idg_batch_end() && rc;
     if ( rc && (flags&TR_TRANSACTION) )
     { int locked = false;
       if ( constraint )
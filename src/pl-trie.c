@@ -230,11 +230,37 @@ trie_create(alloc_pool *pool)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Values that are replaced by trie_insert/3 while the trie is referenced
+may still be read by another thread.  They are released after the last
+reference is gone.  We take the whole list such that a concurrent
+release_trie() cannot free the same value twice.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static void
+release_lingering_value(void *value)
+{ release_value((word)value);
+}
+
+static void
+free_lingering_values(trie *trie)
+{ linger_list *list;
+
+  while( (list=trie->lingering) )
+  { if ( COMPARE_AND_SWAP_PTR(&trie->lingering, list, NULL) )
+    { free_lingering(&list, GEN_MAX);
+      break;
+    }
+  }
+}
+
+
 static void
 trie_destroy(trie *trie)
 { DEBUG(MSG_TRIE_GC, Sdprintf("Destroying trie %p\n", trie));
   trie->magic = TRIE_CMAGIC;
   trie_empty(trie);
+  free_lingering_values(trie);
   free_to_pool(trie->alloc_pool, trie, sizeof(*trie));
 }
 
@@ -279,6 +305,7 @@ void
 trie_clean(trie *trie)
 { if ( trie->magic == TRIE_CMAGIC )
     trie_empty(trie);
+  free_lingering_values(trie);
 }
 
 
@@ -562,6 +589,13 @@ update_var_mask(trie_children_hashed *hnode, word key)
 
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+insert_child() is safe for concurrent  writers without locking: the new
+child is fully initialised (including   its  parent) before it becomes
+visible, either by a CAS  on  the   children  slot  of  `n` or through
+the lock-free hash table of  a   TN_HASHED  node. If the CAS fails the
+children changed under our feet and we retry. If another thread added
+the same key first, we discard our node and return theirs.
+
 (*) The single node may be  in  use   with  another  thread. We have two
 options:
 
@@ -582,6 +616,7 @@ insert_child(DECL_LD trie *trie, trie_node *n, word key)
 
     if ( !new )
       return NULL;			/* resource error */
+    new->parent = n;
 
     if ( children.any )
     { switch( children.any->type )
@@ -604,7 +639,6 @@ insert_child(DECL_LD trie *trie, trie_node *n, word key)
 	    addHTableWP(hnode->table, key, new);
 	    update_var_mask(hnode, children.key->key);
 	    update_var_mask(hnode, new->key);
-	    new->parent = n;
 
 	    if ( COMPARE_AND_SWAP_PTR(&n->children.hash, children.hash, hnode) )
 	    { hnode->old_single = children.key;			/* See (*) */
@@ -622,8 +656,7 @@ insert_child(DECL_LD trie *trie, trie_node *n, word key)
 	{ trie_node *old = addHTableWP(children.hash->table, key, new);
 
 	  if ( new == old )
-	  { new->parent = n;
-	    update_var_mask(children.hash, new->key);
+	  { update_var_mask(children.hash, new->key);
 	  } else
 	  { destroy_node(trie, new);
 	  }
@@ -645,9 +678,7 @@ insert_child(DECL_LD trie *trie, trie_node *n, word key)
       child->child = new;
 
       if ( COMPARE_AND_SWAP_PTR(&n->children.key, NULL, child) )
-      { child->child->parent = n;
 	return child->child;
-      }
       destroy_node(trie, new);
       free_to_pool(trie->alloc_pool, child, sizeof(*child));
     }
@@ -1419,7 +1450,7 @@ set_trie_value_word(trie *trie, trie_node *node, word val)
 
       acquire_key(val);
       node->value = val;
-      set(node, TN_PRIMARY);
+      ATOMIC_OR(&node->flags, TN_PRIMARY);
       release_value(old);
       trie_discard_clause(trie);
 
@@ -1430,7 +1461,7 @@ set_trie_value_word(trie *trie, trie_node *node, word val)
   } else
   { acquire_key(val);
     node->value = val;
-    set(node, TN_PRIMARY);
+    ATOMIC_OR(&node->flags, TN_PRIMARY);
     ATOMIC_INC(&trie->value_count);
     trie_discard_clause(trie);
 
@@ -1491,6 +1522,13 @@ trie_delete(trie *trie, trie_node *node, int prune)
  * True if Key was added as a new   key  to the trie and associated with
  * Value. False if Key was already in the trie with Value
  *
+ * The value is installed using a CAS on the node's value slot, so if
+ * multiple threads insert the same Key concurrently exactly one of them
+ * succeeds.  Together with insert_child() this makes trie_insert/2,3
+ * safe on a trie that is shared between threads.  If trie_update/3
+ * replaces a value while the trie is referenced by a reader, the old
+ * value lingers until the last reference is released.
+ *
  * @error permission_error if Key was associated with a different value
  */
 
@@ -1506,15 +1544,10 @@ trie_insert(DECL_LD term_t Trie, term_t Key, term_t Value, trie_node **nodep,
     int rc;
 
     if ( isoff(trie, TRIE_ISMAP|TRIE_ISSET) )
-    { if ( Value )
-	set(trie, TRIE_ISMAP);
-      else
-	set(trie, TRIE_ISSET);
-    } else
-    { if ( (Value  && isoff(trie, TRIE_ISMAP)) ||
-	   (!Value && isoff(trie, TRIE_ISSET)) )
-      { return PL_permission_error("insert", "trie", Trie);
-      }
+      ATOMIC_OR(&trie->flags, Value ? TRIE_ISMAP : TRIE_ISSET);
+    if ( (Value  && isoff(trie, TRIE_ISMAP)) ||
+	 (!Value && isoff(trie, TRIE_ISSET)) )
+    { return PL_permission_error("insert", "trie", Trie);
     }
 
     kp	= valTermRef(Key);
@@ -1522,41 +1555,44 @@ trie_insert(DECL_LD term_t Trie, term_t Key, term_t Value, trie_node **nodep,
     if ( (rc=trie_lookup_abstract(trie, NULL, &node, kp,
 				  true, abstract, NULL)) == true )
     { word val = intern_value(Value);
+      word old;
 
       if ( nodep )
 	*nodep = node;
 
-      if ( node->value )
-      { if ( update )
-	{ if ( !equal_value(node->value, val) )
-	  { word old = node->value;
-
-	    acquire_key(val);
-	    node->value = val;
-	    set(node, TN_PRIMARY);
-	    release_value(old);
-	    trie_discard_clause(trie);
-	  } else if ( isRecord(val) )
-	  { PL_erase(word2ptr(record_t, val));
+      acquire_key(val);
+      for(;;)
+      { if ( (old=node->value) )
+	{ if ( update )
+	  { if ( equal_value(old, val) )
+	    { release_value(val);
+	      return true;
+	    }
+	    if ( COMPARE_AND_SWAP_WORD(&node->value, old, val) )
+	    { ATOMIC_OR(&node->flags, TN_PRIMARY);
+	      if ( trie->references )
+		linger_always(&trie->lingering, release_lingering_value,
+			      (void*)old);
+	      else
+		release_value(old);
+	      trie_discard_clause(trie);
+	      return true;
+	    }
+	  } else
+	  { if ( !equal_value(old, val) )
+	      PL_permission_error("modify", "trie_key", Key);
+	    release_value(val);
+
+	    return false;
 	  }
+	} else if ( COMPARE_AND_SWAP_WORD(&node->value, 0, val) )
+	{ ATOMIC_OR(&node->flags, TN_PRIMARY);
+	  ATOMIC_INC(&trie->value_count);
+	  trie_discard_clause(trie);
 
 	  return true;
-	} else
-	{ if ( !equal_value(node->value, val) )
-	    PL_permission_error("modify", "trie_key", Key);
-	  if ( isRecord(val) )
-	    PL_erase(word2ptr(record_t, val));
-
-	  return false;
 	}
       }
-      acquire_key(val);
-      node->value = val;
-      set(node, TN_PRIMARY);
-      ATOMIC_INC(&trie->value_count);
-      trie_discard_clause(trie);
-
-      return true;
     }
 
     return trie_error(rc, Key);
@@ -1694,11 +1730,15 @@ PRED_IMPL("trie_lookup", 3, trie_lookup, 0)
 
     kp = valTermRef(A2);
 
+    acquire_trie(trie);
     if ( (rc=trie_lookup(trie, NULL, &node, kp, false, NULL)) == true )
-    { if ( node->value )
-	return unify_value(A3, node->value);
-      return false;
+    { word value = node->value;
+
+      rc = value && unify_value(A3, value);
+      release_trie(trie);
+      return rc;
     }
+    release_trie(trie);
 
     return trie_error(rc, A2);
   }
@@ -1724,6 +1764,324 @@ PRED_IMPL("trie_term", 2, trie_term, 0)
 }
 
 
+		 /*******************************
+		 *	  SET OPERATIONS	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+trie_union/3, trie_intersection/3 and  trie_subtract/2  work directly on
+the trie nodes rather than  on  the   terms.  The  path  to a node is a
+serialization of the term, so the same  term   is  reached  by the same
+sequence of keys in any trie. The   exception  are indirect keys (floats,
+big integers and strings) that are  interned   per  trie and need to be
+translated using trie_translate_key().
+
+trie_set_walk() enumerates all nodes of   `src`, following the matching
+node in `other` (if given)  and   in  `dst`  (if given). Sub-tries that
+have no counterpart in `other` are skipped. As prune_trie(), it uses an
+explicit stack for the choice points   at  hashed nodes and iterates on
+single children, so we do not run out of C stack on deep terms.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef enum
+{ TRIE_SET_COPY,			/* Copy src nodes to dst */
+  TRIE_SET_INTERSECT,			/* Copy src nodes in other to dst */
+  TRIE_SET_SUBTRACT			/* Collect src nodes in other */
+} trie_set_op;
+
+typedef struct trie_set_choice
+{ TableEnum  e;				/* Enumerator for hashed children */
+  trie_node *other;			/* Matching node in other */
+  trie_node *dst;			/* Matching node in dst */
+} trie_set_choice;
+
+#define trie_translate_key(from, to, key, add) \
+	LDFUNC(trie_translate_key, from, to, key, add)
+
+static word
+trie_translate_key(DECL_LD trie *from, trie *to, word key, bool add)
+{ if ( from != to && isIndirect(key) )
+  { Word gsave = gTop;
+    word w = extern_indirect_no_shift(from->indirects, key);
+
+    if ( !w )
+      return TRIE_ERROR_VAL;
+    key = trie_intern_indirect(to, w, add);
+    gTop = gsave;
+  }
+
+  return key;
+}
+
+static bool
+trie_copy_value(trie *dst, trie_node *node, word value)
+{ if ( !node->value )
+  { if ( isRecord(value) )
+    { record_t r = PL_duplicate_record(word2ptr(record_t, value));
+
+      if ( !r )
+	return false;
+      value = ptr2word(r);
+    }
+    set_trie_value_word(dst, node, value);
+  }
+
+  return true;
+}
+
+/* Find the nodes in `other` (*np) and `dst` (*dp) for the src node `n`.
+ * Returns true if the walk must descend into `n`, false if the sub-trie
+ * is not in `other` or a *_OVERFLOW code.
+ */
+
+#define trie_set_follow(src, other, dst, n, np, dp) \
+	LDFUNC(trie_set_follow, src, other, dst, n, np, dp)
+
+static int
+trie_set_follow(DECL_LD trie *src, trie *other, trie *dst,
+		trie_node *n, trie_node **np, trie_node **dp)
+{ word key;
+
+  if ( other )
+  { if ( (key=trie_translate_key(src, other, n->key, false)) == TRIE_ERROR_VAL )
+      return GLOBAL_OVERFLOW;
+    if ( !key || !(*np = get_child(*np, key)) )
+      return false;
+  }
+  if ( dst )
+  { if ( (key=trie_translate_key(src, dst, n->key, true)) == TRIE_ERROR_VAL )
+      return GLOBAL_OVERFLOW;
+    if ( !key || !(*dp = follow_node(dst, *dp, key, true)) )
+      return MEMORY_OVERFLOW;
+  }
+
+  return true;
+}
+
+/* Give `n`, which has no children, an empty hashed children table that
+ * can hold `size` keys.  Copying keys in the order of a hash enumeration
+ * into a small table that is resized on the fly leads to long reprobe
+ * sequences.
+ */
+
+static void
+reserve_hashed_children(trie *trie, trie_node *n, size_t size)
+{ trie_children_hashed *hnode;
+  size_t len = 4;
+
+  while( len < size*2 )
+    len <<= 1;
+
+  if ( (hnode=alloc_from_pool(trie->alloc_pool, sizeof(*hnode))) )
+  { hnode->type       = TN_HASHED;
+    hnode->table      = newHTableWP(len);
+    hnode->var_mask   = 0;
+    hnode->old_single = NULL;
+
+    if ( !COMPARE_AND_SWAP_PTR(&n->children.hash, NULL, hnode) )
+    { destroyHTableWP(hnode->table);
+      free_to_pool(trie->alloc_pool, hnode, sizeof(*hnode));
+    }
+  }
+}
+
+#define trie_set_walk(op, src, other, dst, nodes) \
+	LDFUNC(trie_set_walk, op, src, other, dst, nodes)
+
+static int
+trie_set_walk(DECL_LD trie_set_op op, trie *src, trie *other, trie *dst,
+	      TmpBuffer nodes)
+{ segstack stack;
+  trie_set_choice buffer[64];
+  trie_set_choice ch = { .e = NULL };
+  trie_node *n = &src->root;
+  trie_node *o = other ? &other->root : NULL;
+  trie_node *d = dst ? &dst->root : NULL;
+  int rc;
+
+  initSegStack(&stack, sizeof(trie_set_choice), sizeof(buffer), buffer);
+
+  for(;;)
+  { trie_children children = n->children;
+
+    if ( n->value && (!o || o->value) )
+    { if ( op == TRIE_SET_SUBTRACT )
+      { addBuffer(nodes, n, trie_node*);
+      } else if ( !trie_copy_value(dst, d, n->value) )
+      { rc = MEMORY_OVERFLOW;
+	goto out;
+      }
+    }
+
+    if ( children.any )
+    { switch( children.any->type )
+      { case TN_KEY:
+	{ n = children.key->child;
+	  if ( (rc=trie_set_follow(src, other, dst, n, &o, &d)) == true )
+	    continue;
+	  if ( rc != false )
+	    goto out;
+	  break;
+	}
+	case TN_HASHED:
+	{ if ( dst && !d->children.any )
+	  { size_t size = children.hash->table->size;
+
+	    if ( o )
+	    { trie_children oc = o->children;
+
+	      if ( oc.any && oc.any->type == TN_HASHED )
+		size = min(size, (size_t)oc.hash->table->size);
+	      else
+		size = 0;
+	    }
+	    if ( size > 1 )
+	      reserve_hashed_children(dst, d, size);
+	  }
+	  if ( !pushSegStack(&stack, ch, trie_set_choice) )
+	    outOfCore();
+	  ch.e     = newTableEnumWP(children.hash->table);
+	  ch.other = o;
+	  ch.dst   = d;
+	  break;
+	}
+      }
+    }
+
+    for(;;)
+    { table_value_t v;
+
+      if ( !ch.e )
+      { rc = true;
+	goto out;
+      }
+      if ( advanceTableEnum(ch.e, NULL, &v) )
+      { n = val2ptr(v);
+	o = ch.other;
+	d = ch.dst;
+	if ( (rc=trie_set_follow(src, other, dst, n, &o, &d)) == true )
+	  break;
+	if ( rc != false )
+	  goto out;
+      } else
+      { freeTableEnum(ch.e);
+	popSegStack(&stack, &ch, trie_set_choice);
+      }
+    }
+  }
+
+out:
+  while( ch.e )
+  { freeTableEnum(ch.e);
+    popSegStack(&stack, &ch, trie_set_choice);
+  }
+  clearSegStack(&stack);
+
+  return rc;
+}
+
+
+#define trie_set_new(Trie1, Trie2, Trie, op) \
+	LDFUNC(trie_set_new, Trie1, Trie2, Trie, op)
+
+static foreign_t
+trie_set_new(DECL_LD term_t Trie1, term_t Trie2, term_t Trie, trie_set_op op)
+{ trie *t1, *t2, *t;
+
+  if ( !get_trie(Trie1, &t1) || !get_trie(Trie2, &t2) )
+    return false;
+  if ( op == TRIE_SET_COPY &&
+       ((ison(t1, TRIE_ISMAP) && ison(t2, TRIE_ISSET)) ||
+	(ison(t1, TRIE_ISSET) && ison(t2, TRIE_ISMAP))) )
+    return PL_permission_error("insert", "trie", Trie1);
+
+  if ( (t = trie_create(NULL)) )
+  { atom_t symbol = trie_symbol(t);
+    int rc;
+
+    if ( op == TRIE_SET_COPY )
+    { t->flags |= (t1->flags|t2->flags) & (TRIE_ISMAP|TRIE_ISSET);
+      if ( (rc=trie_set_walk(op, t1, NULL, t, NULL)) == true )
+	rc = trie_set_walk(op, t2, NULL, t, NULL);
+    } else
+    { t->flags |= t1->flags & (TRIE_ISMAP|TRIE_ISSET);
+      rc = trie_set_walk(op, t1, t2, t, NULL);
+      prune_trie(t, &t->root, NULL, NULL);
+    }
+
+    if ( rc == true )
+      rc = unify_trie(Trie, t);
+    else
+      rc = raiseStackOverflow(rc);
+    PL_unregister_atom(symbol);
+
+    return rc;
+  }
+
+  return false;
+}
+
+
+/**
+ * trie_union(+Trie1, +Trie2, -Trie) is det.
+ * trie_intersection(+Trie1, +Trie2, -Trie) is det.
+ *
+ * Create a new Trie holding the keys  that   are  in Trie1 or Trie2 (in
+ * both for trie_intersection/3).  If a key is in both tries, its value
+ * is taken from Trie1.  trie_union/3 raises a permission error if one
+ * of the tries is a set (see trie_insert/2) and the other a map.
+ */
+
+static
+PRED_IMPL("trie_union", 3, trie_union, 0)
+{ PRED_LD
+
+  return trie_set_new(A1, A2, A3, TRIE_SET_COPY);
+}
+
+static
+PRED_IMPL("trie_intersection", 3, trie_intersection, 0)
+{ PRED_LD
+
+  return trie_set_new(A1, A2, A3, TRIE_SET_INTERSECT);
+}
+
+/**
+ * trie_subtract(+Trie1, +Trie2) is det.
+ *
+ * Delete all keys from Trie1 that are in Trie2, regardless of their
+ * value.  We first collect the nodes as deleting them may prune the
+ * hash tables we are enumerating.
+ */
+
+static
+PRED_IMPL("trie_subtract", 2, trie_subtract, 0)
+{ PRED_LD
+  trie *t1, *t2;
+
+  if ( get_trie(A1, &t1) && get_trie(A2, &t2) )
+  { tmp_buffer buf;
+    int rc;
+
+    initBuffer(&buf);
+    if ( (rc=trie_set_walk(TRIE_SET_SUBTRACT, t1, t2, NULL, &buf)) == true )
+    { trie_node **np = baseBuffer(&buf, trie_node*);
+      trie_node **ep = topBuffer(&buf, trie_node*);
+
+      for(; np < ep; np++)
+	trie_delete(t1, *np, true);
+    } else
+    { rc = raiseStackOverflow(rc);
+    }
+    discardBuffer(&buf);
+
+    return rc;
+  }
+
+  return false;
+}
+
+
 /**
  * trie_gen(+Trie, ?Key, -Value) is nondet.
  *
@@ -2057,12 +2415,21 @@ typedef struct trie_choice
   word       novar;
   word       key;
   trie_node *child;
+  unsigned   part_count;	/* Only enumerate keys in partition */
+  unsigned   part_index;
 } trie_choice;
 
+typedef struct trie_partition
+{ trie_node   *split;		/* Node whose children are partitioned */
+  unsigned     count;		/* # partitions (0: not partitioned) */
+  unsigned     index;		/* Partition we enumerate */
+} trie_partition;
+
 typedef struct
 { trie	      *trie;		/* trie we operate on */
   int	       allocated;	/* If true, the state is persistent */
   unsigned     vflags;		/* TN_PRIMARY or TN_SECONDARY */
+  trie_partition partition;	/* trie_gen_partition/4,5 */
   tmp_buffer   choicepoints;	/* Stack of trie state choicepoints */
 } trie_gen_state;
 
@@ -2088,10 +2455,46 @@ init_trie_state(trie_gen_state *state, trie *trie, const trie_node *root)
 { state->trie = trie;
   state->allocated = false;
   state->vflags = root == &trie->root ? TN_PRIMARY : TN_SECONDARY;
+  state->partition.split = NULL;
+  state->partition.count = 0;
   initBuffer(&state->choicepoints);
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+trie_gen_partition/4,5 split the answers   of  a trie by the children of
+the first node that has hashed children.   A key belongs to a partition
+based on its hash, so we do not depend on the order of the enumeration.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static trie_node *
+trie_split_node(trie_node *n)
+{ trie_children children;
+
+  while( (children=n->children).any && children.any->type == TN_KEY )
+    n = children.key->child;
+
+  return n;
+}
+
+static inline bool
+in_partition(unsigned count, unsigned index, word key)
+{ return ( !count ||
+	   MurmurHashAligned2(&key, sizeof(key), MURMUR_SEED)%count == index );
+}
+
+static inline void
+set_choice_partition(const trie_gen_state *state, const trie_node *node,
+		     trie_choice *ch)
+{ if ( state->partition.count && node == state->partition.split )
+  { ch->part_count = state->partition.count;
+    ch->part_index = state->partition.index;
+  } else
+  { ch->part_count = 0;
+  }
+}
+
+
 #define base_choice(state) baseBuffer(&state->choicepoints, trie_choice)
 #define top_choice(state) topBuffer(&state->choicepoints, trie_choice)
 
@@ -2258,6 +2661,11 @@ add_choice(DECL_LD trie_gen_state *state, descent_state *dstate, trie_node *node
 	{ if ( children.hash->var_mask == 0 )
 	  { trie_node *child;
 
+	    if ( node == state->partition.split &&
+		 !in_partition(state->partition.count,
+			       state->partition.index, k) )
+	      return NULL;
+
 	    if ( (child = lookupHTableWP(children.hash->table, k)) )
 	    { ch = allocFromBuffer(&state->choicepoints, sizeof(*ch));
 	      ch->key        = k;
@@ -2280,6 +2688,7 @@ add_choice(DECL_LD trie_gen_state *state, descent_state *dstate, trie_node *node
 	    ch->var_mask   = children.hash->var_mask;
 	    ch->var_index  = 1;
 	    ch->novar      = k;
+	    set_choice_partition(state, node, ch);
 	    if ( advance_node(ch) )
 	    { return ch;
 	    } else
@@ -2294,11 +2703,12 @@ add_choice(DECL_LD trie_gen_state *state, descent_state *dstate, trie_node *node
 	ch = allocFromBuffer(&state->choicepoints, sizeof(*ch));
 	ch->table = NULL;
 	ch->table_enum = newTableEnumWP(children.hash->table);
-	table_key_t tk;
-	table_value_t tv;
-	advanceTableEnum(ch->table_enum, &tk, &tv);
-	ch->key   = tk;
-	ch->child = val2ptr(tv);
+	set_choice_partition(state, node, ch);
+	if ( !advance_node(ch) )
+	{ freeTableEnum(ch->table_enum);
+	  state->choicepoints.top = (char*)ch;
+	  return NULL;
+	}
 	break;
       }
       default:
@@ -2333,25 +2743,30 @@ advance_node(DECL_LD trie_choice *ch)
   { table_key_t k;
     table_value_t v;
 
-    if ( advanceTableEnum(ch->table_enum, &k, &v) )
-    { ch->key   = k;
-      ch->child = val2ptr(v);
+    while( advanceTableEnum(ch->table_enum, &k, &v) )
+    { if ( in_partition(ch->part_count, ch->part_index, k) )
+      { ch->key   = k;
+	ch->child = val2ptr(v);
 
-      return true;
+	return true;
+      }
     }
   } else if ( ch->table )
   { if ( ch->novar )
-    { if ( (ch->child=lookupHTableWP(ch->table, ch->novar)) )
+    { if ( in_partition(ch->part_count, ch->part_index, ch->novar) &&
+	   (ch->child=lookupHTableWP(ch->table, ch->novar)) )
       { ch->key = ch->novar;
 	ch->novar = 0;
 	return true;
       }
+      ch->novar = 0;
     }
     for( ; ch->var_index && ch->var_index < VMASKBITS; ch->var_index++ )
     { if ( (ch->var_mask & (0x1<<(ch->var_index-1))) )
       { word key = ((((word)ch->var_index))<<LMASK_BITS)|TAG_VAR;
 
-	if ( (ch->child=lookupHTableWP(ch->table, key)) )
+	if ( in_partition(ch->part_count, ch->part_index, key) &&
+	     (ch->child=lookupHTableWP(ch->table, key)) )
 	{ ch->key = key;
 	  ch->var_index++;
 	  return true;
@@ -2441,10 +2856,11 @@ unify_trie_path(DECL_LD term_t term, trie_node **tn, trie_gen_state *gstate)
 }
 
 
-foreign_t
-trie_gen_raw(trie *trie, trie_node *root, term_t Key, term_t Value,
-	     term_t Data, bool LDFUNCP (*unify_data)(DECL_LD term_t, trie_node*, void *ctx),
-	     void *ctx, control_t PL__ctx)
+static foreign_t
+trie_gen_part(trie *trie, trie_node *root, const trie_partition *part,
+	      term_t Key, term_t Value,
+	      term_t Data, bool LDFUNCP (*unify_data)(DECL_LD term_t, trie_node*, void *ctx),
+	      void *ctx, control_t PL__ctx)
 { PRED_LD
   trie_gen_state state_buf;
   trie_gen_state *state;
@@ -2467,6 +2883,8 @@ trie_gen_raw(trie *trie, trie_node *root, term_t Key, term_t Value,
       acquire_trie(trie);
       state = &state_buf;
       init_trie_state(state, trie, root);
+      if ( part )
+	state->partition = *part;
       rc = ( (ch = add_choice(state, &dstate, root)) &&
 	     (ch = descent_node(state, &dstate, ch)) &&
 	     (ison(ch->child, state->vflags) || next_choice(state)) );
@@ -2528,6 +2946,7 @@ trie_gen_raw(trie *trie, trie_node *root, term_t Key, term_t Value,
 
 	  nstate->trie = state->trie;
 	  nstate->vflags = state->vflags;
+	  nstate->partition = state->partition;
 	  nstate->allocated = true;
 	  if ( ochp->base == ochp->static_buffer )
 	  { size_t bytes = ochp->top - ochp->base;
@@ -2559,6 +2978,15 @@ next:;
 }
 
 
+foreign_t
+trie_gen_raw(trie *trie, trie_node *root, term_t Key, term_t Value,
+	     term_t Data, bool LDFUNCP (*unify_data)(DECL_LD term_t, trie_node*, void *ctx),
+	     void *ctx, control_t PL__ctx)
+{ return trie_gen_part(trie, root, NULL, Key, Value, Data,
+		       unify_data, ctx, PL__ctx);
+}
+
+
 foreign_t
 trie_gen(term_t Trie, term_t Root, term_t Key, term_t Value,
 	 term_t Data, bool LDFUNCP (*unify_data)(DECL_LD term_t, trie_node*, void *ctx),
@@ -2600,6 +3028,67 @@ PRED_IMPL("trie_gen", 2, trie_gen, PL_FA_NONDETERMINISTIC)
 { return trie_gen(A1, 0, A2, 0, 0, NULL, NULL, PL__ctx);
 }
 
+
+/**
+ * trie_gen_partition(+Trie, +Count, +Index, ?Key) is nondet.
+ * trie_gen_partition(+Trie, +Count, +Index, ?Key, -Value) is nondet.
+ *
+ * As trie_gen/2,3, but only enumerate partition Index (0..Count-1) of
+ * the trie.  The Count partitions are disjoint and together enumerate
+ * the entire trie.  If the trie has no hashed node, all keys are in
+ * partition 0.
+ */
+
+static foreign_t
+trie_gen_partition(term_t Trie, term_t Count, term_t Index,
+		   term_t Key, term_t Value, control_t PL__ctx)
+{ if ( CTX_CNTRL == FRG_FIRST_CALL )
+  { trie *trie;
+    size_t count, index;
+
+    if ( get_trie(Trie, &trie) &&
+	 PL_get_size_ex(Count, &count) &&
+	 PL_get_size_ex(Index, &index) )
+    { trie_partition part;
+
+      if ( count == 0 || count > UINT_MAX )
+	return PL_domain_error("not_less_than_one", Count);
+      if ( index >= count )
+	return PL_domain_error("partition_index", Index);
+      if ( !trie->root.children.any )
+	return false;
+
+      part.split = trie_split_node(&trie->root);
+      if ( !part.split->children.any || count == 1 )
+      { if ( index > 0 )
+	  return false;
+	part.count = 0;
+      } else
+      { part.count = (unsigned)count;
+	part.index = (unsigned)index;
+      }
+
+      return trie_gen_part(trie, &trie->root, &part, Key, Value, 0,
+			   NULL, NULL, PL__ctx);
+    }
+
+    return false;
+  } else
+  { return trie_gen_part(NULL, NULL, NULL, Key, Value, 0,
+			 NULL, NULL, PL__ctx);
+  }
+}
+
+static
+PRED_IMPL("trie_gen_partition", 5, trie_gen_partition, PL_FA_NONDETERMINISTIC)
+{ return trie_gen_partition(A1, A2, A3, A4, A5, PL__ctx);
+}
+
+static
+PRED_IMPL("trie_gen_partition", 4, trie_gen_partition, PL_FA_NONDETERMINISTIC)
+{ return trie_gen_partition(A1, A2, A3, A4, 0, PL__ctx);
+}
+
 #define unify_node_id(t, answer, ctx) \
 	LDFUNC(unify_node_id, t, answer, ctx)
 
@@ -2627,12 +3116,22 @@ PRED_IMPL("$trie_property", 2, trie_property, 0)
   static atom_t ATOM_gen_call_count = 0;
   static atom_t ATOM_invalidated = 0;
   static atom_t ATOM_reevaluated = 0;
-
-  if ( !ATOM_lookup_count )
-  { ATOM_lookup_count   = PL_new_atom("lookup_count");
-    ATOM_gen_call_count = PL_new_atom("gen_call_count");
-    ATOM_invalidated    = PL_new_atom("invalidated");
-    ATOM_reevaluated    = PL_new_atom("reevaluated");
+  static atom_t ATOM_call_count = 0;
+  static atom_t ATOM_complete_call_count = 0;
+  static atom_t ATOM_answers_added = 0;
+  static atom_t ATOM_duplicate_answers = 0;
+  static atom_t ATOM_completion_time = 0;
+
+  if ( !ATOM_completion_time )
+  { ATOM_lookup_count        = PL_new_atom("lookup_count");
+    ATOM_gen_call_count      = PL_new_atom("gen_call_count");
+    ATOM_invalidated         = PL_new_atom("invalidated");
+    ATOM_reevaluated         = PL_new_atom("reevaluated");
+    ATOM_call_count          = PL_new_atom("call_count");
+    ATOM_complete_call_count = PL_new_atom("complete_call_count");
+    ATOM_answers_added       = PL_new_atom("answers_added");
+    ATOM_duplicate_answers   = PL_new_atom("duplicate_answers");
+    ATOM_completion_time     = PL_new_atom("completion_time");
   }
 #endif
 
@@ -2680,6 +3179,16 @@ PRED_IMPL("$trie_property", 2, trie_property, 0)
       { return PL_unify_int64(arg, trie->stats.lookups);
       } else if ( name == ATOM_gen_call_count)
       { return PL_unify_int64(arg, trie->stats.gen_call);
+      } else if ( name == ATOM_call_count && ison(trie, TRIE_ISTABLE) )
+      { return PL_unify_int64(arg, trie->stats.calls);
+      } else if ( name == ATOM_complete_call_count && ison(trie, TRIE_ISTABLE) )
+      { return PL_unify_int64(arg, trie->stats.complete_calls);
+      } else if ( name == ATOM_answers_added && ison(trie, TRIE_ISTABLE) )
+      { return PL_unify_int64(arg, trie->stats.answers);
+      } else if ( name == ATOM_duplicate_answers && ison(trie, TRIE_ISTABLE) )
+      { return PL_unify_int64(arg, trie->stats.duplicates);
+      } else if ( name == ATOM_completion_time && ison(trie, TRIE_ISTABLE) )
+      { return PL_unify_float(arg, trie->stats.eval_time);
 #ifdef O_PLMT
       } else if ( name == ATOM_wait )
       { return PL_unify_int64(arg, trie->stats.wait);
@@ -3472,8 +3981,13 @@ BeginPredDefs(trie)
   PRED_DEF("trie_lookup",	    3, trie_lookup,	     0)
   PRED_DEF("trie_delete",	    3, trie_delete,	     0)
   PRED_DEF("trie_term",		    2, trie_term,	     0)
+  PRED_DEF("trie_union",	    3, trie_union,	     0)
+  PRED_DEF("trie_intersection",	    3, trie_intersection,    0)
+  PRED_DEF("trie_subtract",	    2, trie_subtract,	     0)
   PRED_DEF("trie_gen",		    3, trie_gen,	     NDET)
   PRED_DEF("trie_gen",		    2, trie_gen,	     NDET)
+  PRED_DEF("trie_gen_partition",    4, trie_gen_partition,   NDET)
+  PRED_DEF("trie_gen_partition",    5, trie_gen_partition,   NDET)
   PRED_DEF("$trie_gen_node",	    3, trie_gen_node,	     NDET)
   PRED_DEF("$trie_property",	    2, trie_property,	     0)
 #if O_NESTED_TRIES
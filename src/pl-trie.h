@@ -116,6 +116,7 @@ typedef struct trie
 #endif
   trie_node		root;		/* the root node */
   indirect_table       *indirects;	/* indirect values */
+  struct linger_list   *lingering;	/* values replaced while in use */
   void		      (*release_node)(struct trie *, trie_node *);
   alloc_pool	       *alloc_pool;	/* Node allocation pool */
   atom_t		clause;		/* Compiled representation */
@@ -123,6 +124,12 @@ typedef struct trie
   struct
   { uint64_t		lookups;	/* trie_lookup */
     uint64_t		gen_call;	/* trie_gen calls */
+    uint64_t		calls;		/* tabled calls using this table */
+    uint64_t		complete_calls;	/* ... finding it complete */
+    uint64_t		answers;	/* answers added */
+    uint64_t		duplicates;	/* duplicate answers rejected */
+    double		eval_start;	/* WallTime() evaluation started */
+    double		eval_time;	/* Wall time spent until complete */
 #ifdef O_PLMT
     unsigned int	deadlock;	/* times involved in a deadlock */
     unsigned int	wait;		/* times waited for */
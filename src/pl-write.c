@@ -417,14 +417,7 @@ Putc(int c, IOSTREAM *s)
 
 static bool
 PutString(const char *str, IOSTREAM *s)
-{ const unsigned char *q = (const unsigned char *)str;
-
-  for( ; *q != EOS; q++ )
-  { if ( Sputcode(*q, s) == EOF )
-      return false;
-  }
-
-  return true;
+{ return Sputs_latin1(str, strlen(str), s) == 0;
 }
 
 
@@ -448,15 +441,7 @@ PutBar(write_options *options)
 
 static bool
 PutStringN(const char *str, size_t length, IOSTREAM *s)
-{ size_t i;
-  const unsigned char *q = (const unsigned char *)str;
-
-  for(i=0; i<length; i++, q++)
-  { if ( Sputcode(*q, s) == EOF )
-      return false;
-  }
-
-  return true;
+{ return Sputs_latin1(str, length, s) == 0;
 }
 
 
@@ -831,12 +816,7 @@ writeUCSAtom(IOSTREAM *fd, atom_t atom, int flags)
     if ( !PutOpenToken(c, fd) )
       return false;
 
-    while ( s < e )
-    { s = get_wchar(s, &c);
-
-      if ( !Putc(c, fd) )
-	return false;
-    }
+    return Sputs_wchar(s, e-s, fd) == 0;
   }
 
   return true;
@@ -935,28 +915,13 @@ writeString(term_t t, write_options *options)
   } else
   { switch(txt.encoding)
     { case ENC_ISO_LATIN_1:
-      { const unsigned char *s = (const unsigned char*)txt.text.t;
-	const unsigned char *e = &s[txt.length];
-
-	while(s<e)
-	{ int chr = *s++;
-
-	  if ( !(rc=Putc(chr, options->out)) )
-	    goto out;
-	}
+      { if ( !(rc=PutStringN(txt.text.t, txt.length, options->out)) )
+	  goto out;
 	break;
       }
       case ENC_WCHAR:
-      { const wchar_t *s = txt.text.w;
-	const wchar_t *e = &s[txt.length];
-
-	while(s<e)
-	{ int chr;
-
-	  s = get_wchar(s, &chr);
-	  if ( !(rc=Putc(chr, options->out)) )
-	    goto out;
-	}
+      { if ( !(rc=(Sputs_wchar(txt.text.w, txt.length, options->out) == 0)) )
+	  goto out;
 	break;
       }
       default:
@@ -981,7 +946,8 @@ complicated to avoid. Second, it does not provide a mode that guarantees
 reliable read-back. Using %g gets closest,   but %.15g doesn't guarantee
 read-back and %.17g does, but prints 0.1 as 0.100..001, etc.
 
-This uses dtoa.c. See pl-dtoa.c for how this is packed into SWI-Prolog.
+The digits are computed by  dtoa_shortest()   from  pl-ryu.c, which produces
+the same digits as dtoa() from dtoa.c in mode 0, but much faster.
 
 TBD: The number of cases are large. We should see whether it is possible
 to clean this up a bit. The 5 cases   as  such are real: there is no way
@@ -1160,7 +1126,8 @@ Return:
 
 size_t
 format_float(char *buf, size_t size, double f, int N, char E)
-{ char *end, *o=buf, *s;
+{ char digits[24];
+  char *end, *o=buf, *s=digits;
   int decpt, sign;
   size_t sz;
   char *limit = &buf[size];
@@ -1168,9 +1135,9 @@ format_float(char *buf, size_t size, double f, int N, char E)
   if ( (sz=format_special_float(buf, size, f)) )
     return sz;
 
-  s = dtoa(f, 0, 30, &decpt, &sign, &end);
+  end = s + dtoa_shortest(f, digits, &decpt, &sign);
   DEBUG(MSG_WRITE_FLOAT,
-	Sdprintf("dtoa(): decpt=%d, sign=%d, len = %d, '%s'\n",
+	Sdprintf("dtoa_shortest(): decpt=%d, sign=%d, len = %d, '%s'\n",
 		 decpt, sign, end-s, s));
 
 #undef OUT				/* minwindef.h */
@@ -1241,8 +1208,6 @@ format_float(char *buf, size_t size, double f, int N, char E)
 #undef OUTS
 #undef OUT
 
-  freedtoa(s);
-
   if ( o < limit )
     *o = 0;
   else if ( size > 0 )
@@ -1323,20 +1288,35 @@ writeNumber(DECL_LD term_t t, write_options *options)
   PL_get_number(t, &n);
 
   switch(n.type)
-  { case V_INTEGER:
-    case V_FLOAT:
+  { case V_FLOAT:
+      if ( options->float_format == ATOM_float_format_specifier )
+      { char tmp[64];			/* default "~h": avoid format/2 */
+	size_t len = format_float(tmp, sizeof(tmp), n.value.f, 3, 'e');
+
+	if ( len < sizeof(tmp) )
+	  return PutToken(tmp, options->out);
+      }
+      /*FALLTHROUGH*/
+    case V_INTEGER:
 #ifdef O_BIGNUM
     case V_MPZ:
 #endif
     { PL_chars_t fmt;
+      atom_t a = (n.type == V_FLOAT ? options->float_format
+				    : options->integer_format);
+
+      if ( n.type == V_INTEGER && a == ATOM_int_format_specifier )
+      { char tmp[32];			/* default "~d": avoid format/2 */
+
+	snprintf(tmp, sizeof(tmp), "%" PRId64, n.value.i);
+	return PutToken(tmp, options->out);
+      }
 
-      get_atom_text(n.type == V_FLOAT ? options->float_format
-				      : options->integer_format,
-		    &fmt);
+      get_atom_text(a, &fmt);
       if ( !separate_number(options->out, &n, &fmt) )
 	return false;
 
-      return do_format(options->out, &fmt, 1, t, options->module);
+      return do_format(options->out, &fmt, a, 1, t, options->module);
     }
 #ifdef O_BIGNUM
     case V_MPQ:
@@ -1525,6 +1505,196 @@ callPortray(term_t arg, int prec, write_options *options)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Iterative writer for lists and canonical compounds.  Huge lists and deeply
+nested terms such as f(f(...)) or [[...]] are written using an explicit
+stack of write_frame structures rather than recursion on the C stack.  A
+frame holds a term reference to the compound being written; frames are
+created in stack order, such that popping a frame can release its term
+references using PL_reset_term_refs().  The bottom frame uses a copy of
+the caller's term reference because the list case modifies the frame's
+term and resetting the caller's reference would release term references
+below the foreign frame opened by writeTerm().
+
+Only compounds for which writeTerm2() would use plain f(...) or [...]
+syntax are handled here.  These are all compounds if there is no
+portray, no depth limit and the functor is not an operator, {}/1, a dict
+or '$VAR'/1.  Anything else is passed to writeTerm(), which may call
+writeTermIterative() again for its arguments.  Cycles have already been
+removed by writeTopTerm().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define WF_COMPOUND	0		/* f(a1, ...) */
+#define WF_LIST		1		/* [e1, ...] */
+#define WF_LIST_TAIL	2		/* [...|Tail] */
+
+typedef struct write_frame
+{ term_t	term;			/* compound or list cell */
+  size_t	arg;			/* argument index (compound) */
+  size_t	arity;			/* arity (compound) */
+  int		type;			/* WF_* */
+} write_frame;
+
+#define iterativeCompound(t, options, name, arity) \
+	LDFUNC(iterativeCompound, t, options, name, arity)
+
+static int
+iterativeCompound(DECL_LD term_t t, write_options *options,
+		  atom_t *name, size_t *arity)
+{ atom_t f;
+  size_t a;
+
+  if ( !PL_get_compound_name_arity(t, &f, &a) )
+    return -1;
+
+  if ( f == ATOM_dot && a == 2 )
+    return isoff(options, PL_WRT_DOTLISTS|PL_WRT_NO_LISTS) ? WF_LIST : -1;
+  if ( (f == ATOM_curl && a == 1) ||
+       f == ATOM_dict ||
+       (f == ATOM_isovar && a == 1 &&
+	ison(options, PL_WRT_NUMBERVARS|PL_WRT_VARNAMES)) )
+    return -1;
+  if ( a <= 3 &&
+       isoff(options, PL_WRT_IGNOREOPS) &&
+       priorityOperator(options->module, f) > 0 )
+    return -1;
+
+  *name = f;
+  *arity = a;
+  return WF_COMPOUND;
+}
+
+#define pushWriteFrame(stack, t, options) \
+	LDFUNC(pushWriteFrame, stack, t, options)
+
+static int
+pushWriteFrame(DECL_LD tmp_buffer *stack, term_t t, write_options *options)
+{ write_frame fr = { .term = t };
+  atom_t name;
+
+  if ( (fr.type = iterativeCompound(t, options, &name, &fr.arity)) < 0 )
+    return false;
+  if ( fr.type == WF_COMPOUND )
+  { if ( !writeAtom(name, options) ||
+	 !Putc('(', options->out) )
+      return -1;
+  } else
+  { if ( !Putc('[', options->out) )
+      return -1;
+  }
+  addBuffer(stack, fr, write_frame);
+
+  return true;
+}
+
+#define writeTermIterative(t, prec, options, flags) \
+	LDFUNC(writeTermIterative, t, prec, options, flags)
+
+static bool
+writeTermIterative(DECL_LD term_t t, int prec, write_options *options,
+		   int flags)
+{ tmp_buffer stack;
+  IOSTREAM *out = options->out;
+  term_t t0;
+  bool rc;
+
+  if ( !(t0 = PL_copy_term_ref(t)) )
+    return false;
+
+  initBuffer(&stack);
+  switch( pushWriteFrame(&stack, t0, options) )
+  { case false:
+      PL_reset_term_refs(t0);
+      return writeTerm2(t, prec, options, flags);
+    case -1:
+      discardBuffer(&stack);
+      return false;
+  }
+
+  while( !isEmptyBuffer(&stack) )
+  { write_frame *fr = topBuffer(&stack, write_frame)-1;
+    term_t arg;
+    int argflags;
+
+    switch(fr->type)
+    { case WF_COMPOUND:
+	if ( fr->arg == fr->arity )
+	{ PL_reset_term_refs(fr->term);
+	  (void)popBufferP(&stack, write_frame);
+	  if ( !Putc(')', out) )
+	    goto error;
+	  continue;
+	}
+	if ( fr->arg > 0 && !PutComma(options) )
+	  goto error;
+	arg = PL_new_term_ref();
+	_PL_get_arg(++fr->arg, fr->term, arg);
+	argflags = W_COMPOUND_ARG;
+	break;
+      case WF_LIST:
+	arg = PL_new_term_ref();
+	if ( fr->arg == 0 )		/* first element */
+	{ fr->arg++;
+	  _PL_get_arg(1, fr->term, arg);
+	  argflags = W_LIST_ARG;
+	  break;
+	}
+	_PL_get_arg(2, fr->term, arg);
+	if ( PL_get_nil(arg) )
+	{ PL_reset_term_refs(fr->term);
+	  (void)popBufferP(&stack, write_frame);
+	  if ( !Putc(']', out) )
+	    goto error;
+	  continue;
+	}
+	if ( PL_is_functor(arg, FUNCTOR_dot2) )
+	{ PL_put_term(fr->term, arg);
+	  _PL_get_arg(1, fr->term, arg);
+	  if ( !PutComma(options) )
+	    goto error;
+	  argflags = W_LIST_ARG;
+	} else
+	{ fr->type = WF_LIST_TAIL;
+	  if ( !Putc('|', out) )
+	    goto error;
+	  argflags = W_LIST_TAIL;
+	}
+	break;
+      case WF_LIST_TAIL:
+      default:
+	PL_reset_term_refs(fr->term);
+	(void)popBufferP(&stack, write_frame);
+	if ( !Putc(']', out) )
+	  goto error;
+	continue;
+    }
+
+    if ( PL_handle_signals() < 0 )
+      goto error;
+
+    if ( PL_is_compound(arg) )
+    { switch( pushWriteFrame(&stack, arg, options) )
+      { case true:
+	  continue;
+	case -1:
+	  goto error;
+      }
+    }
+    rc = writeTerm2(arg, 999, options, argflags);
+    PL_reset_term_refs(arg);
+    if ( !rc )
+      goto error;
+  }
+
+  discardBuffer(&stack);
+  return true;
+
+error:
+  discardBuffer(&stack);
+  return false;
+}
+
+
 static bool
 writeTerm(term_t t, int prec, write_options *options, int flags)
 { GET_LD
@@ -1543,6 +1713,10 @@ writeTerm(term_t t, int prec, write_options *options, int flags)
   if ( ++options->depth > options->max_depth && options->max_depth )
   { PutOpenToken('.', options->out);
     rval = PutString("...", options->out);
+  } else if ( !options->max_depth &&
+	      isoff(options, PL_WRT_PORTRAY) &&
+	      PL_is_compound(t) )
+  { rval = writeTermIterative(t, prec, options, flags);
   } else
   { rval = writeTerm2(t, prec, options, flags);
   }
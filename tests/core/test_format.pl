@@ -94,4 +94,26 @@ test(onstring_1) :-
     string(S),
     atom_string('hello world', S).
 
+test(repeat, L == ["a1b","a2b","a3b"]) :-
+    findall(S, (between(1, 3, I), format(string(S), 'a~wb', [I])), L).
+test(nested, S == "<x[y]>") :-
+    format(string(S), '<~w~@>', [x, format('[~w]', [y])]).
+test(nested_same, S == "(a(b))") :-
+    format(string(S), '(~w~@)', [a, format('(~w~@)', [b, true])]).
+test(wide_literal, S == "\u00e9t\u00e9 \u4e2d 1") :-
+    format(string(S), '\u00e9t\u00e9 \u4e2d ~w', [1]).
+test(column, S == "abc   x\nde    x") :-
+    format(string(S), 'abc~6|x~nde~6|x', []).
+test(invalid_arg, error(format('invalid argument'))) :-
+    format(string(_), 'ab~-x', []).
+test(agc, true) :-
+    forall(between(1, 3, _),
+	   ( forall(between(1, 200, I),
+		    ( format(atom(F), 'f~w ~~w', [I]),
+		      format(string(S), F, [x]),
+		      format(string(S), 'f~w x', [I])
+		    )),
+	     garbage_collect_atoms
+	   )).
+
 :- end_tests(format).
@@ -47,7 +47,9 @@ of these these are in pre-unit test format in the main test.pl
 
 test_io :-
 	run_tests([ io,
-		    stream_pair
+		    stream_pair,
+		    map,
+		    async
 		  ]).
 
 :- begin_tests(io, [sto(rational_trees)]).
@@ -90,6 +92,143 @@ test(current_io_closed,
 test(input_is_not_output, fail) :-
 	current_input(X),
 	current_output(X).
+test(copy_binary, Copy == Expected) :-
+	numlist(0, 255, Bytes),
+	atom_codes(Data, Bytes),
+	tmp_file_stream(octet, File, Out0),
+	forall(between(1, 1000, _), write(Out0, Data)),
+	close(Out0),
+	tmp_file(copy, CopyFile),
+	setup_call_cleanup(
+	    open(File, read, In, [type(binary)]),
+	    ( get_byte(In, _),
+	      setup_call_cleanup(
+		  open(CopyFile, write, Out, [type(binary)]),
+		  ( copy_stream_data(In, Out, 255),
+		    copy_stream_data(In, Out),
+		    stream_property(Out, position(Pos)),
+		    stream_position_data(byte_count, Pos, Count)
+		  ),
+		  close(Out))
+	    ),
+	    close(In)),
+	assertion(Count == 255999),
+	read_file_to_string(File, All, [type(binary)]),
+	sub_string(All, 1, _, 0, Expected),
+	read_file_to_string(CopyFile, Copy, [type(binary)]),
+	delete_file(File),
+	delete_file(CopyFile).
+test(owned_output, [ condition(current_prolog_flag(threads, true)),
+		     [E,Text] = [error(permission_error(access, stream, _), _),
+				 "ab"]
+		   ]) :-
+	tmp_file_stream(utf8, File, Out),
+	set_stream(Out, owned(true)),
+	assertion(stream_property(Out, owned(true))),
+	write(Out, a),
+	thread_create(catch(write(Out, x), E0, thread_exit(E0)), Id1),
+	thread_join(Id1, exited(E)),
+	set_stream(Out, owned(false)),
+	assertion(\+ stream_property(Out, owned(_))),
+	thread_create(write(Out, b), Id2),
+	thread_join(Id2, true),
+	close(Out),
+	read_file_to_string(File, Text, []),
+	delete_file(File).
+test(owned_exit, [ condition(current_prolog_flag(threads, true)),
+		   Text == "ab"
+		 ]) :-
+	tmp_file_stream(utf8, File, Out),
+	thread_create(( set_stream(Out, owned(true)),
+			write(Out, a)
+		      ), Id),
+	thread_join(Id, true),
+	assertion(\+ stream_property(Out, owned(_))),
+	write(Out, b),
+	close(Out),
+	read_file_to_string(File, Text, []),
+	delete_file(File).
+test(read_string_pos, Pos == pos(4, 4, 24, 26)) :-
+	tmp_file_stream(utf8, File, Out),
+	format(Out, 'ab\tc\nline two\nxyz \u20AC\nlast', []),
+	close(Out),
+	setup_call_cleanup(
+	    open(File, read, In, [encoding(utf8)]),
+	    ( read_string(In, _, String),
+	      stream_pos(In, Pos)
+	    ),
+	    close(In)),
+	delete_file(File),
+	assertion(String == "ab\tc\nline two\nxyz \u20AC\nlast").
+test(read_lines, L == ["ab", "c\u20ACd", "", "last"]) :-
+	open_string("ab\r\nc\u20ACd\n\nlast", In),
+	read_lines(In, L, []).
+test(read_lines_max, L1-L2-L3 == [a,b]-[c]-[]) :-
+	open_string("a\nb\nc\n", In),
+	read_lines(In, L1, [max_count(2), as(atom)]),
+	read_lines(In, L2, [as(atom)]),
+	read_lines(In, L3, []).
+test(read_lines_sep, L == [[0'x], [], [0'y]]) :-
+	open_string("x;;y", In),
+	read_lines(In, L, [separator(;), as(codes)]).
+test(write_string_pos, Pos == pos(3, 1, 9, 11)) :-
+	tmp_file_stream(utf8, File, Out),
+	write(Out, "a\tb\nc\u20ACd\n"),
+	write(Out, e),
+	stream_pos(Out, Pos),
+	close(Out),
+	delete_file(File).
+test(adaptive_buffer, Terms-Size == 20000-100) :-
+	tmp_file_stream(text, File, Out),
+	forall(between(1, 20000, I), format(Out, 't(~d).~n', [I])),
+	close(Out),
+	setup_call_cleanup(
+	    open(File, read, In0),
+	    ( read_terms(In0, 0, Terms),
+	      stream_property(In0, buffer_size(Size0))
+	    ),
+	    close(In0)),
+	assertion(Size0 > 4096),
+	setup_call_cleanup(
+	    open(File, read, In, [buffer_size(100)]),
+	    ( read_terms(In, 0, Terms),
+	      stream_property(In, buffer_size(Size))
+	    ),
+	    close(In)),
+	delete_file(File).
+test(stream_pool, Hits >= 100) :-
+	statistics(stream_pool_hits, H0),
+	forall(between(1, 100, _),
+	       with_output_to(string(_), write(x))),
+	statistics(stream_pool_hits, H1),
+	Hits is H1-H0.
+test(memory_output, Len-Last == 588896-0'\u20AC) :-
+	numlist(1, 100000, L),
+	with_output_to(codes(Codes, [0'\u20AC]),
+		       forall(member(X, L), (write(X), write(' ')))),
+	length(Codes, Len),
+	last(Codes, Last).
+test(memory_output_encoding, [Enc,S] == [utf8,"a\u00e9\u20AC\U0001F600"]) :-
+	with_output_to(string(S),
+		       ( current_output(Out),
+			 stream_property(Out, encoding(Enc)),
+			 format('a\u00e9\u20AC\U0001F600')
+		       )).
+test(memory_output_set_encoding, error(permission_error(encoding, stream, _))) :-
+	with_output_to(string(_),
+		       ( current_output(Out),
+			 set_stream(Out, encoding(octet))
+		       )).
+test(adaptive_pipe, [ condition(current_prolog_flag(pipe, true)),
+		      Size == Default
+		    ]) :-
+	current_prolog_flag(stream_buffer_size, Default),
+	setup_call_cleanup(
+	    open(pipe('seq 1 20000'), read, In),
+	    ( read_string(In, _, _),
+	      stream_property(In, buffer_size(Size))
+	    ),
+	    close(In)).
 test(reuse_alias, error(permission_error(open, source_sink, alias(a)))) :-
 	setup_call_cleanup(
 	    ( open_null_stream(S),
@@ -100,6 +239,22 @@ test(reuse_alias, error(permission_error(open, source_sink, alias(a)))) :-
 
 :- end_tests(io).
 
+stream_pos(S, pos(Line, LinePos, Chars, Bytes)) :-
+	line_count(S, Line),
+	line_position(S, LinePos),
+	character_count(S, Chars),
+	stream_property(S, position(Pos)),
+	stream_position_data(byte_count, Pos, Bytes).
+
+read_terms(In, N0, N) :-
+	read_term(In, T, []),
+	(   T == end_of_file
+	->  N = N0
+	;   N1 is N0+1,
+	    assertion(T == t(N1)),
+	    read_terms(In, N1, N)
+	).
+
 :- begin_tests(stream_pair, [sto(rational_trees)]).
 
 test(single, In == user_input) :-
@@ -119,3 +274,188 @@ test(close, true) :-
 	assertion(var(Out)).
 
 :- end_tests(stream_pair).
+
+:- begin_tests(map, [sto(rational_trees)]).
+
+test(read, Terms == [t(1),t(2),t(3)]) :-
+	map_file(File),
+	setup_call_cleanup(
+	    open(File, read, In, [map(true)]),
+	    read_terms(In, Terms),
+	    close(In)).
+test(reposition, T1-T2 == t(2)-t(1)) :-
+	map_file(File),
+	setup_call_cleanup(
+	    open(File, read, In, [map(true)]),
+	    ( read(In, _),
+	      stream_property(In, position(Pos)),
+	      read(In, _),
+	      set_stream_position(In, Pos),
+	      read(In, T1),
+	      read_pending_codes(In, _, []),
+	      seek(In, 0, bof, _),
+	      read(In, T2)
+	    ),
+	    close(In)).
+test(pipe, [ condition(current_prolog_flag(pipe, true)),
+	     T == t(1)
+	   ]) :-
+	setup_call_cleanup(
+	    open(pipe('echo "t(1)."'), read, In, [map(true)]),
+	    read(In, T),
+	    close(In)).
+test(empty, T == end_of_file) :-
+	tmp_file_stream(text, File, Out),
+	close(Out),
+	setup_call_cleanup(
+	    open(File, read, In, [map(true)]),
+	    read(In, T),
+	    ( close(In),
+	      delete_file(File)
+	    )).
+test(tiny, Strings == ["a", "ab", "abc"]) :-
+	findall(S,
+		( member(S0, ["a", "ab", "abc"]),
+		  tmp_file_stream(text, File, Out),
+		  write(Out, S0),
+		  close(Out),
+		  setup_call_cleanup(
+		      open(File, read, In, [map(true)]),
+		      read_string(In, _, S),
+		      ( close(In),
+			delete_file(File)
+		      ))
+		),
+		Strings).
+test(peek, S == "(2).\nt(3).\n") :-
+	map_file(File),
+	setup_call_cleanup(
+	    open(File, read, In, [map(true)]),
+	    ( read(In, _),
+	      get_char(In, _),
+	      get_char(In, _),
+	      peek_string(In, 100, S)
+	    ),
+	    close(In)).
+test(large, [ condition(large_file_ok),
+	      [C,T,E] == ['\u0000',t(1),end_of_file]
+	    ]) :-
+	Offset is 0x80000010,
+	tmp_file_stream(binary, File, Out0),
+	close(Out0),
+	setup_call_cleanup(
+	    ( open(File, write, Out, [type(binary)]),
+	      seek(Out, Offset, bof, _),
+	      format(Out, 't(1).~n', []),
+	      close(Out),
+	      open(File, read, In, [map(true)])
+	    ),
+	    ( get_char(In, C),
+	      seek(In, Offset, bof, _),
+	      read(In, T),
+	      read(In, E)
+	    ),
+	    ( close(In),
+	      delete_file(File)
+	    )).
+
+large_file_ok :-
+	current_prolog_flag(address_bits, 64).
+
+:- dynamic
+	map_file_/1.
+
+map_file(File) :-
+	map_file_(File),
+	!.
+map_file(File) :-
+	tmp_file_stream(text, File, Out),
+	forall(between(1, 3, I),
+	       format(Out, 't(~d).~n', [I])),
+	close(Out),
+	asserta(map_file_(File)).
+
+read_terms(In, Terms) :-
+	read(In, T0),
+	(   T0 == end_of_file
+	->  Terms = []
+	;   Terms = [T0|Rest],
+	    read_terms(In, Rest)
+	).
+
+:- end_tests(map).
+
+:- begin_tests(async, [sto(rational_trees)]).
+
+test(write_read, Lines == 10000) :-
+	tmp_file_stream(text, File, Out0),
+	close(Out0),
+	setup_call_cleanup(
+	    open(File, write, Out, [async(4)]),
+	    forall(between(1, 10000, I),
+		   format(Out, 'line ~d~n', [I])),
+	    close(Out)),
+	setup_call_cleanup(
+	    open(File, read, In, [async(2)]),
+	    count_lines(In, 0, Lines),
+	    close(In)),
+	delete_file(File).
+test(property, Depth == 4) :-
+	tmp_file_stream(text, File, Out0),
+	close(Out0),
+	setup_call_cleanup(
+	    open(File, write, Out, [async(4)]),
+	    (   io_uring_enabled
+	    ->  stream_property(Out, async(Depth))
+	    ;   Depth = 4
+	    ),
+	    close(Out)),
+	delete_file(File).
+test(device, [ condition(\+ current_prolog_flag(windows, true)),
+	       Term == end_of_file
+	     ]) :-
+	setup_call_cleanup(
+	    open('/dev/null', read, In, [async(2)]),
+	    ( assertion(\+ stream_property(In, async(_))),
+	      read(In, Term)
+	    ),
+	    close(In)).
+test(pipe, [ condition(current_prolog_flag(pipe, true)),
+	     Term == end_of_file
+	   ]) :-
+	setup_call_cleanup(
+	    open(pipe('true'), read, In, [async(2)]),
+	    ( assertion(\+ stream_property(In, async(_))),
+	      read(In, Term)
+	    ),
+	    close(In)).
+test(seek, L1-L2 == "line 3"-"line 1") :-
+	tmp_file_stream(text, File, Out),
+	forall(between(1, 3, I),
+	       format(Out, 'line ~d~n', [I])),
+	close(Out),
+	setup_call_cleanup(
+	    open(File, read, In, [async(2)]),
+	    ( seek(In, 14, bof, _),
+	      read_line_to_string(In, L1),
+	      seek(In, 0, bof, _),
+	      read_line_to_string(In, L2)
+	    ),
+	    close(In)),
+	delete_file(File).
+
+io_uring_enabled :-
+	exists_file('/proc/sys/kernel/io_uring_disabled'),
+	read_file_to_string('/proc/sys/kernel/io_uring_disabled', S, []),
+	split_string(S, "", " \n", ["0"]).
+
+count_lines(In, N0, N) :-
+	read_line_to_string(In, L),
+	(   L == end_of_file
+	->  N = N0
+	;   assertion(sub_string(L, 0, _, _, "line ")),
+	    N1 is N0+1,
+	    count_lines(In, N1, N)
+	).
+
+:- end_tests(async).
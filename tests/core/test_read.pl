@@ -49,7 +49,9 @@ Test term reading, notably option processing
 test_read :-
     run_tests([ read_term,
                 read_op,
-		read_numbers
+		read_numbers,
+		read_data,
+		read_reuse
 	      ]).
 
 :- begin_tests(read_term).
@@ -189,9 +191,109 @@ test(float_overflow, F =:= inf) :-
         set_prolog_flag(float_overflow, infinity),
         term_string(F, '1.797693134862316e+308', []),
         set_prolog_flag(float_overflow, Old)).
+test(float_exact, Q == 3602879701896397r36028797018963968) :-
+    term_string(F, "0.1"),
+    Q is rational(F).
+test(float_round_even, F == 9007199254740992.0) :-
+    term_string(F, "9007199254740993.0").
+test(float_long, F == 1.0000000000000002) :-
+    term_string(F, "1.000000000000000111022302462515654042363166809082031250001").
+test(float_subnormal, F > 0.0) :-
+    term_string(F, "2.4703282292062328e-324").
 
 :- end_tests(read_numbers).
 
+:- begin_tests(read_data).
+
+test(canonical, T == f(a,'B',"s",[1,2|c],-1,-2.5e3,0'a,{x},[],-(1),'-')) :-
+    term_string(T, "f(a,'B',\"s\",[1,2|c],-1,-2.5e3,0'a,{x},[],-(1),'-')",
+		[syntax(data), double_quotes(string)]).
+test(variables, T-Names =@= f(X,Y,X)-['X'=X,'Y'=Y]) :-
+    term_string(T, "f(X,Y,X)", [syntax(data), variable_names(Names)]).
+test(positions, Pos == term_position(0,9,0,1,[2-3,list_position(4,8,[5-7],none)])) :-
+    term_string(_, "f(a,[bc])", [syntax(data), subterm_positions(Pos)]).
+test(infix, error(syntax_error(operator_expected))) :-
+    term_string(_, "a-b", [syntax(data)]).
+test(prefix, error(syntax_error(operator_expected))) :-
+    term_string(_, "f(- a)", [syntax(data)]).
+test(directive, error(syntax_error(operator_expected))) :-
+    term_string(_, ":- dynamic(p/1)", [syntax(data)]).
+test(stream, Terms == [f(1),g([a,b]),end_of_file]) :-
+    setup_call_cleanup(
+	open_string("f(1). g([a, b]).\n% comment\n", In),
+	read_data_terms(In, Terms),
+	close(In)).
+test(syntax, error(domain_error(syntax, nosuch))) :-
+    term_string(_, "a", [syntax(nosuch)]).
+
+read_data_terms(In, [T|Ts]) :-
+    read_term(In, T, [syntax(data)]),
+    (   T == end_of_file
+    ->  Ts = []
+    ;   read_data_terms(In, Ts)
+    ).
+
+:- end_tests(read_data).
+
+:- begin_tests(read_reuse).
+
+% Subsequent reads reuse the buffers and variable table of the previous
+% read.  Alternate large and small terms to verify nothing leaks between
+% them.
+
+test(variables) :-
+    forall(member(N, [40,2,100,20,3]),
+	   ( var_names(N, Names),
+	     atomic_list_concat(Names, ',', Args),
+	     format(string(S), "f(~w,~w)", [Args,Args]),
+	     term_string(T, S, [variable_names(Bindings)]),
+	     length(Bindings, N),
+	     maplist(binding, Bindings, Names, Vs),
+	     T =.. [f|Vars],
+	     append(Vs, Vs, Vars1),
+	     Vars == Vars1
+	   )).
+test(stream, Terms =@= [L, a(X,Y,X,Y), L, b]) :-
+    numlist(1, 1000, L),
+    format(string(S), "~w. a(X,Y,X,Y). ~w. b.", [L,L]),
+    setup_call_cleanup(
+	open_string(S, In),
+	findall(T, (between(1,4,_), read(In, T)), Terms),
+	close(In)).
+test(statistics, R1 > R0) :-
+    term_string(_, "f(X,Y,[a,b,c])"),
+    statistics(read_buffers_reused, R0),
+    forall(between(1, 10, _), term_string(_, "f(X,Y,[a,b,c])")),
+    statistics(read_buffers_reused, R1).
+test(option_error, A1 == A0) :-	% errors return the buffers
+    var_names(200, Names),
+    atomic_list_concat(Names, ',', Args),
+    format(string(S), "f(~w,\"~w\").", [Args,Args]),
+    read_from_string(S, []),
+    statistics(read_buffers_allocated, A0),
+    forall(between(1, 10, _),
+	   ( catch(read_from_string(S, [double_quotes(bogus)]), _, true),
+	     read_from_string(S, [])
+	   )),
+    statistics(read_buffers_allocated, A1).
+
+:- end_tests(read_reuse).
+
+var_names(N, Names) :-
+    findall(Name,
+	    ( between(1, N, I),
+	      format(atom(Name), 'V~w', [I])
+	    ),
+	    Names).
+
+binding(Name=Var, Name, Var).
+
+read_from_string(String, Options) :-
+    setup_call_cleanup(
+	open_string(String, In),
+	read_term(In, _, Options),
+	close(In)).
+
 term_position_check(TermString, ExpectedTerm, ExpectedTermPos) :-
     term_position_check(TermString, ExpectedTerm, ExpectedTermPos, []).
 
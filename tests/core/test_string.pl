@@ -83,6 +83,26 @@ test(split_string, L == ["SWI-Prolog"]) :-
 	split_string("  SWI-Prolog  ", "", "\s\t\n", L).
 test(split_string, L == [""]) :-
 	split_string(" ", "", " ", L).
+test(split_string, L == ["", "home", "", "jan", "", "", "nice", "path"]) :-
+	split_string("/home//jan///nice/path", "/", "", L).
+test(split_string, L == ["a", "b", "c", "d", "e", "f"]) :-
+	split_string("a,b;c:d|e f", ",;:| ", "", L).
+test(split_string, L == ["a", "b", "c", "d", "e", "f", ""]) :-
+	split_string("a,b;c:d|e-f.", ",;:|-.", "", L).
+test(split_string, L == ["a", "b", "c"]) :-
+	split_string(" a ,\tb  , c\n", ",", " \t\n", L).
+test(split_string, L == ["\u00e9t\u00e9", "\u4e2d\u6587", "x"]) :-
+	split_string("\u00e9t\u00e9,\u4e2d\u6587;x", ",;", "", L).
+test(split_string, L == ["a", "b"]) :-
+	split_string("a\u4e2db", "\u4e2d", "", L).
+test(split_string, Parts == 1001) :-
+	numlist(0, 1000, Nums),
+	atomic_list_concat(Nums, ',', Atom),
+	split_string(Atom, ",", " ", L),
+	length(L, Parts),
+	last(L, "1000").
+test(split_string, L == ["abcdefghijklmnopqrstuvwxyz"]) :-
+	split_string("   abcdefghijklmnopqrstuvwxyz   ", "", " ", L).
 test(string_lower, L == "abc") :-
 	string_lower("aBc", L).
 test(string_upper, L == "ABC") :-
@@ -254,6 +254,35 @@ test(neg, C = '\235\') :-		% test signed char handling
 	sub_atom('Azi\235\', _, 1, 0, C).
 test(nondet, X == 3) :-			% det when matching at last position
 	sub_atom('cadabra', X, 4, _, 'abra').
+test(search, Bs == [0,1,2,3]) :-		% overlapping matches
+	findall(B, sub_atom(aaaaa, B, _, _, aa), Bs).
+test(search, Bs == [0,7]) :-
+	findall(B, sub_atom(abracadabra, B, _, _, abra), Bs).
+test(search, [nondet, B-A == 2-3]) :-		% search lazily for the next
+	sub_atom(abcdefg, B, _, A, cd).
+test(search, fail) :-
+	sub_atom(abcdefg, _, _, _, dc).
+test(search, Bs == [0,1,2,3]) :-
+	findall(B, sub_atom(abc, B, _, _, ''), Bs).
+test(search, Bs == [3]) :-			% aliased before and after
+	findall(B, sub_atom(abcxxxabc, B, _, B, abc), Bs0),
+	findall(B, sub_atom(xxxabcxxx, B, _, B, abc), Bs),
+	Bs0 == [].
+test(wide, Bs == [1,5]) :-
+	findall(B, sub_atom('\x3b1\ab\x3b2\\x3b1\ab\x3b2\', B, _, _, 'ab\x3b2\'), Bs).
+test(mixed, Bs == [1,5]) :-
+	findall(B, sub_atom('\x3b1\abc\x3b2\ab', B, _, _, ab), Bs).
+test(mixed, fail) :-
+	sub_atom(abcabc, _, _, _, 'b\x3b1\').
+test(string, Bs == [0,4]) :-
+	findall(B, sub_string("ab, ab", B, _, _, "ab"), Bs).
+test(long, B == 100001) :-
+	length(L, 100000),
+	maplist(=(0'a), L),
+	atom_codes(A0, L),
+	atom_concat(A0, 'aab', A),
+	sub_atom(A, B, _, 0, ab),
+	sub_atom(A, B, _, _, ab).
 
 :- end_tests(sub_atom).
 
@@ -267,6 +296,16 @@ test(error, error(instantiation_error)) :-
 	atomic_list_concat([1,_], _).
 test(error, error(domain_error(non_empty_atom, ''))) :-
 	atomic_list_concat(_L, '', text).
+test(split, L == [a, '', b, '']) :-
+	atomic_list_concat(L, ',', 'a,,b,').
+test(split, L == ['', a, b]) :-
+	atomic_list_concat(L, '::', '::a::b').
+test(split, L == [abc]) :-
+	atomic_list_concat(L, xyz, abc).
+test(split, L == [a, b]) :-
+	atomic_list_concat(L, '\u4e2d', 'a\u4e2db').
+test(split, L == [x, y]) :-
+	atomic_list_concat(L, ab, "xaby").
 
 :- end_tests(atomic_list_concat).
 
@@ -51,7 +51,8 @@ test_write :-
 		    write_quoted,
 		    write_variable_names,
 		    write_float,
-		    write_misc
+		    write_misc,
+		    write_deep
 		  ]).
 
 :- meta_predicate
@@ -236,6 +237,22 @@ test(nan) :-
 	atom_number(F, Float),
 	abs(Float) >= 1,
 	abs(Float) < 2.
+test(shortest, L == ['0.1', '1.0e+22', '5.0e-324', '1.7976931348623157e+308',
+		     '2.2250738585072014e-308', '9007199254740992.0', '-0.0',
+		     '1.0e-05', '0.0001', '123456789012345.0']) :-
+	maplist([F,A]>>format(atom(A), '~w', [F]),
+		[ 0.1, 1.0e22, 5.0e-324, 1.7976931348623157e308,
+		  2.2250738585072014e-308, 9007199254740992.0, -0.0,
+		  1.0e-5, 1.0e-4, 123456789012345.0
+		], L).
+test(round_trip, true) :-
+	set_random(seed(1)),
+	forall(between(1, 10000, _),
+	       ( X is (random_float-0.5) * 10.0**(random(600)-300),
+		 term_to_atom(X, A),
+		 term_to_atom(Y, A),
+		 X == Y
+	       )).
 
 :- end_tests(write_float).
 
@@ -282,6 +299,50 @@ test(s_1, X = '[(a,b)]') :-
 
 :- end_tests(write_misc).
 
+:- begin_tests(write_deep).
+
+test(nested_compound, Len == 3000001) :-
+    nest(f, 1000000, a, T),
+    with_output_to(string(S), write(T)),
+    string_length(S, Len).
+test(nested_list, S == "[[[[a,x],x],x],x]") :-
+    nest_list(4, a, T),
+    with_output_to(string(S), write(T)).
+test(nested_list, Len == 1200001) :-
+    nest_list(300000, a, T),
+    with_output_to(string(S), writeq(T)),
+    string_length(S, Len).
+test(roundtrip, T2 == T) :-
+    nest(g, 10000, [1,"s",'A'|b], T0),
+    T = [h(T0,c)-x],
+    term_string(T, S),
+    term_string(T2, S).
+test(mixed, S == "f(-(1),[a|b],{}(x),:(a,b),'$VAR'(1),-(1),[])") :-
+    with_output_to(string(S),
+		   write_canonical(f(-(1),[a|b],{x},a:b,'$VAR'(1),- 1,[]))).
+test(mixed, S == "f(- 1,[a|b],{x},a:b,B,- 1,[])") :-
+    with_output_to(string(S),
+		   writeq(f(-(1),[a|b],{x},a:b,'$VAR'(1),- 1,[]))).
+test(spacing, S == "f(a, [b, c|d], g(- 1))") :-
+    with_output_to(string(S),
+		   write_term(f(a,[b,c|d],g(-(1))), [spacing(next_argument)])).
+test(max_depth, S == "f(f(f(...)))") :-
+    nest(f, 10, a, T),
+    with_output_to(string(S), write_term(T, [max_depth(3)])).
+
+nest(_, 0, T, T) :- !.
+nest(F, N, T0, T) :-
+    N1 is N-1,
+    T1 =.. [F,T0],
+    nest(F, N1, T1, T).
+
+nest_list(0, T, T) :- !.
+nest_list(N, T0, T) :-
+    N1 is N-1,
+    nest_list(N1, [T0,x], T).
+
+:- end_tests(write_deep).
+
 write_encoding(Goal, Encoding, String) :-
 	setup_call_cleanup(
 	    tmp_file_stream(File, Out, [encoding(Encoding)]),
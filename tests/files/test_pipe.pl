@@ -138,6 +138,73 @@ collect_data(C, Fd, [C|T]) :-
     collect_data(C2, Fd, T).
 
 
+		 /*******************************
+		 *	       POLLER		*
+		 *******************************/
+
+test(poller,
+     [ condition(( current_predicate(system:poller_create/1),
+                   \+ current_prolog_flag(windows, true))),
+       Ready-Line == [in]-"hello"
+     ]) :-
+    poller_create(P),
+    setup_call_cleanup(
+        ( open(pipe('echo hello'), read, In, [bom(false)]),
+          open_blocked_pipe('', Idle, Release)
+        ),
+        ( poller_add(P, In, in),
+          poller_add(P, Idle, idle),
+          poller_wait(P, Ready, infinite),
+          read_line_to_string(In, Line),
+          assertion(poller_delete(P, In)),
+          assertion(\+ poller_delete(P, In))
+        ),
+        ( close(In),
+          release_pipe(Idle, Release)
+        )).
+test(poller_buffered,
+     [ condition(( current_predicate(system:poller_create/1),
+                   \+ current_prolog_flag(windows, true))),
+       Ready == [a,b]
+     ]) :-
+    poller_create(P),
+    setup_call_cleanup(
+        ( open_blocked_pipe('a1\\na2\\n', A, ReleaseA),
+          open_blocked_pipe('b1\\nb2\\n', B, ReleaseB)
+        ),
+        ( read_line_to_string(A, _),	% leaves a2 in the buffer
+          read_line_to_string(B, _),
+          poller_add(P, A, a),
+          poller_add(P, B, b),
+          assertion(\+ poller_wait(P, [], 0)),
+          poller_wait(P, Ready0, 0),
+          msort(Ready0, Ready)
+        ),
+        ( release_pipe(A, ReleaseA),
+          release_pipe(B, ReleaseB)
+        )).
+
+%!  open_blocked_pipe(+Data, -In, -Fifo) is det.
+%
+%   Open a pipe from a process that writes Data using a single write and
+%   keeps the pipe open without writing anything else until Fifo is
+%   opened and closed by release_pipe/2.  This avoids depending on the
+%   timing of the process.
+
+open_blocked_pipe(Data, In, Fifo) :-
+    tmp_file(fifo, Fifo),
+    format(string(Mkfifo), 'mkfifo \'~w\'', [Fifo]),
+    shell(Mkfifo),
+    format(atom(Cmd), 'printf \'~w\'; cat \'~w\' > /dev/null',
+           [Data, Fifo]),
+    open(pipe(Cmd), read, In, [bom(false)]).
+
+release_pipe(In, Fifo) :-
+    open(Fifo, write, Out),
+    close(Out),
+    close(In),
+    delete_file(Fifo).
+
 		 /*******************************
 		 *	      TIMEOUT		*
 		 *******************************/
@@ -35,7 +35,9 @@
 :- use_module(library(plunit)).
 
 test_csv :-
-	run_tests([ csv_read_file_row ]).
+	run_tests([ csv_read_file_row,
+		    csv_read_stream
+		  ]).
 
 :- begin_tests(csv_read_file_row, []).
 :- use_module(library(csv)).
@@ -117,3 +119,74 @@ test(quoted_crlf_ignored) :-
           ].
 
 :- end_tests(csv_read_file_row).
+
+:- begin_tests(csv_read_stream, []).
+:- use_module(library(csv)).
+
+csv_string(String, Rows, Options) :-
+	setup_call_cleanup(
+	    open_string(String, In),
+	    csv_read_stream(In, Rows, Options),
+	    close(In)).
+
+test(file, Rows == [row(a1,a2,a3), row(b1,b2,b3)]) :-
+	test_csv:csv_file('normal.csv', File),
+	csv_read_file(File, Rows, []).
+test(quoted_crlf, Rows == [row(a1,'a2_1\r\na2_2'), row(b1,b2)]) :-
+	csv_string("a1,\"a2_1\r\na2_2\"\r\nb1,b2\r\n", Rows, []).
+test(convert, Rows == [row(1, 2.5, -3, '1x', '')]) :-
+	csv_string("1,2.5,-3,1x,\n", Rows, []).
+test(no_convert, Rows == [row('1', '2.5')]) :-
+	csv_string("1,2.5", Rows, [convert(false)]).
+test(strings, Rows == [row("a", 1, "")]) :-
+	csv_string("a,1,", Rows, [field_type(string)]).
+test(case, Rows == [row(abc, 'x\u4e2d', 42)]) :-
+	csv_string("ABC,X\u4e2d,42", Rows, [case(down)]).
+test(case, Rows == [row("ABC", "1E")]) :-
+	csv_string("abc,1e", Rows, [case(up), field_type(string)]).
+test(strip, Rows == [row(a, 'b c', '')]) :-
+	csv_string("  a ,\tb c\t,  ", Rows, [strip(true)]).
+test(no_strip, Rows == [row(' a ', ' b')]) :-
+	csv_string(" a , b", Rows, []).
+test(quotes, Rows == [row('a,b', 'say "hi"', 'x\ny', 12)]) :-
+	csv_string("\"a,b\",\"say \"\"hi\"\"\",\"x\ny\",\"12\"", Rows, []).
+test(ignore_quotes, Rows == [row('"a', 'b"')]) :-
+	csv_string("\"a,b\"", Rows, [ignore_quotes(true)]).
+test(unterminated, fail) :-
+	csv_string("a,\"b\n", _, []).
+test(garbage, fail) :-
+	csv_string("\"a\"b,c\n", _, []).
+test(separator, Rows == [row(a, 'b,c'), row(d, '')]) :-
+	csv_string("a;b,c\r\nd;\r\n", Rows, [separator(0';)]).
+test(eol, Rows == [row(a), row(b), row(c), row(''), row(d)]) :-
+	csv_string("a\nb\r\nc\r\rd", Rows, []).
+test(wide, Rows == [row('\u4e2d\u6587', 'x\u00e9')]) :-
+	csv_string("\u4e2d\u6587,x\u00e9\n", Rows, []).
+test(functor, Rows == [r(a, b)]) :-
+	csv_string("a,b\n", Rows, [functor(r)]).
+test(arity, error(domain_error(row_arity(2), 1))) :-
+	csv_string("a,b\nc\n", _, []).
+test(arity, Rows == [row(a,b), row(c)]) :-
+	csv_string("a,b\nc\n", Rows, [match_arity(false)]).
+test(skip_header, Rows == [row(a,b)]) :-
+	csv_string("# comment\n#more\n\na,b\n", Rows, [skip_header('#')]).
+test(skip_header, Rows == [row(x,y), row(1,2)]) :-
+	csv_string("#h\rx,y\r1,2\r", Rows, [skip_header('#')]).
+test(skip_header, Rows == [row(x,y), row(1,2)]) :-
+	csv_string("#h\r\n#i\r\nx,y\r\n1,2\r\n", Rows, [skip_header('#')]).
+test(long, Len == 1000) :-
+	numlist(1, 1000, L),
+	atomic_list_concat(L, ',', Line),
+	csv_string(Line, [Row], []),
+	functor(Row, row, Len),
+	arg(1000, Row, 1000).
+test(row, Rows == [row(a,'b\nc'), end_of_file]) :-
+	csv_options(Compiled, []),
+	setup_call_cleanup(
+	    open_string("a,\"b\r\nc\"\r\n", In),
+	    findall(Row, ( between(1, 2, _),
+			   csv_read_row(In, Row, Compiled)
+			 ), Rows),
+	    close(In)).
+
+:- end_tests(csv_read_stream).
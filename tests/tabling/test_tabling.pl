@@ -78,7 +78,8 @@ test_tabling :-
                 pathss,
 
                 bas,
-                push_ret
+                push_ret,
+                table_statistics
 	      ]).
 
 		 /*******************************
@@ -1364,6 +1365,36 @@ test(push_ret, MaxSteps1 == MaxSteps2) :-
 
 :- end_tests(push_ret).
 
+:- begin_tests(table_statistics, [cleanup(abolish_all_tables)]).
+
+:- use_module(library(tables), [table_statistics/2]).
+
+:- table conn/2.
+
+conn(X, Y) :- link(X, Y).
+conn(X, Y) :- conn(X, Z), link(Z, Y).
+
+link(1, 2).
+link(2, 3).
+link(3, 1).
+
+test(counters, Counts == 3-1-9-9) :-
+    abolish_all_tables,
+    forall(conn(_,_), true),
+    forall(conn(_,_), true),
+    table_statistics(conn(_,_), S),
+    get_dict(calls, S, Calls),
+    get_dict(complete_calls, S, Complete),
+    get_dict(answers, S, Answers),
+    get_dict(answers_added, S, Added),
+    Counts = Calls-Complete-Answers-Added,
+    get_dict(duplicate_answers, S, Duplicates),
+    assertion(Duplicates > 0),
+    get_dict(bytes, S, Bytes),
+    assertion(Bytes > 0).
+
+:- end_tests(table_statistics).
+
 
 		 /*******************************
 		 *	      COMMON		*
@@ -46,7 +46,8 @@
 */
 
 test_transact_incr :-
-    run_tests([ test_transact_incr_1
+    run_tests([ test_transact_incr_1,
+                test_transact_incr_batch
               ]).
 
 :- meta_predicate
@@ -140,6 +141,77 @@ test(snapshot, [cleanup(cleanup([d/1]))]) :-
 
 :- end_tests(test_transact_incr_1).
 
+% ================================================================
+% Batched invalidation
+
+:- begin_tests(test_transact_incr_batch).
+
+:- dynamic e/1 as incremental.
+:- table q/1 as (incremental).
+
+q(X) :- e(X).
+
+:- table qs/1 as (incremental, shared).
+
+qs(X) :- e(X).
+
+% Changes in a batch are merged.  Repeated changes to an invalidated
+% node do not propagate without a batch either, so they do not count
+% as coalesced.
+test(batch, [cleanup(cleanup([e/1])), true(Changes-Merged == 3-0)]) :-
+    assertz(e(1)),
+    expect(X, q(X), [1]),
+    statistics(idg_changes, N0),
+    statistics(idg_changes_coalesced, C0),
+    incr_batch_update(( assertz(e(2)),
+                        assertz(e(3)),
+                        assertz(e(4))
+                      )),
+    statistics(idg_changes, N1),
+    statistics(idg_changes_coalesced, C1),
+    Changes is N1-N0,
+    Merged is C1-C0,
+    expect_invalid(q(_)),
+    expect(X, q(X), [1,2,3,4]),
+    expect_valid(q(_)).
+
+% Tables called inside the batch see the pending changes
+test(batch_call, [cleanup(cleanup([e/1]))]) :-
+    assertz(e(1)),
+    expect(X, q(X), [1]),
+    incr_batch_update(( assertz(e(2)),
+                        expect(X, q(X), [1,2]),
+                        assertz(e(3))
+                      )),
+    expect_invalid(q(_)),
+    expect(X, q(X), [1,2,3]).
+
+% Transactions batch as well
+test(transaction, [cleanup(cleanup([e/1]))]) :-
+    assertz(e(1)),
+    expect(X, q(X), [1]),
+    transaction(( assertz(e(2)),
+                  assertz(e(3))
+                )),
+    expect_invalid(q(_)),
+    expect(X, q(X), [1,2,3]).
+
+% A thread that exits inside a batch flushes its pending changes
+test(thread_exit, [cleanup(cleanup([e/1]))]) :-
+    assertz(e(1)),
+    expect(X, qs(X), [1]),
+    thread_self(Me),
+    thread_create(( '$idg_batch_start'(_),
+                    assertz(e(2)),
+                    thread_send_message(Me, changed)
+                  ), Id),
+    thread_get_message(changed),
+    thread_join(Id),
+    expect_invalid(qs(_)),
+    expect(X, qs(X), [1,2]).
+
+:- end_tests(test_transact_incr_batch).
+
 
 		 /*******************************
 		 *         TEST HELPERS		*
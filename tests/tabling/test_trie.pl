@@ -43,6 +43,7 @@
 :- use_module(library(lists)).
 :- use_module(library(debug)).
 :- use_module(library(pairs)).
+:- use_module(library(aggregate)).
 
 test_trie :-
 	run_tests([ trie
@@ -167,6 +168,94 @@ test(gen_compiled3_cycle, error(type_error(acyclic_term,_))) :-
 	X = f(X),
 	trie_insert(T, x, X),
 	forall(trie_gen_compiled(T, K, V), writeln(K-V)).
+test(concurrent_insert,
+     [ condition(current_prolog_flag(threads, true)),
+       Inserted-Count == 2000-2000
+     ]) :-
+	trie_new(T),
+	numlist(1, 4, Ns),
+	maplist(insert_thread(T), Ns, Ids),
+	maplist(join_count, Ids, Counts),
+	sum_list(Counts, Inserted),
+	trie_property(T, value_count(Count)).
+test(concurrent_update,
+     [ condition(current_prolog_flag(threads, true)),
+       Bad == [0,0,0]
+     ]) :-
+	trie_new(T),
+	trie_insert(T, k, v(0,0)),
+	thread_create(update_keys(T), Updater),
+	numlist(1, 3, Ns),
+	maplist(lookup_thread(T), Ns, Ids),
+	thread_join(Updater),
+	maplist(join_count, Ids, Bad).
+test(union, Keys =@= [1.5, "s", a, f(1), f(2), h(_), g(X,X)]) :-
+	set_trie([a, f(1), g(X,X), 1.5], T1),
+	set_trie([f(2), g(Y,Y), "s", h(_), a], T2),
+	trie_union(T1, T2, T),
+	trie_keys(T, Keys),
+	trie_property(T, value_count(7)).
+test(union_value, V == 1) :-
+	trie_new(T1),
+	trie_new(T2),
+	trie_insert(T1, k, 1),
+	trie_insert(T2, k, 2),
+	trie_union(T1, T2, T),
+	trie_lookup(T, k, V).
+test(union_map_set, error(permission_error(insert, trie, T1))) :-
+	trie_new(T1),
+	trie_new(T2),
+	trie_insert(T1, k, 1),
+	trie_insert(T2, k),
+	trie_union(T1, T2, _).
+test(union_set_map, error(permission_error(insert, trie, T1))) :-
+	trie_new(T1),
+	trie_new(T2),
+	trie_insert(T1, k),
+	trie_insert(T2, k, 1),
+	trie_union(T1, T2, _).
+test(intersection, Keys =@= [1.5, h(_), g(X,X)]) :-
+	set_trie([a, f(1), g(X,X), h(_), 1.5], T1),
+	set_trie([f(2), g(Y,Y), h(_), 1.5, g(a,b)], T2),
+	trie_intersection(T1, T2, T),
+	trie_keys(T, Keys),
+	trie_property(T, node_count(7)).
+test(subtract, Keys =@= [a, f(1)]) :-
+	set_trie([a, f(1), g(X,X), h(_), "s"], T1),
+	set_trie([f(2), g(Y,Y), h(_), "s", g(a,b)], T2),
+	trie_subtract(T1, T2),
+	trie_keys(T1, Keys),
+	trie_property(T1, value_count(2)).
+test(subtract_deep, Count == 0) :-
+	numlist(1, 100000, L),
+	set_trie([L], T),
+	trie_subtract(T, T),
+	trie_property(T, value_count(Count)).
+test(gen_partition, Parts == All) :-
+	trie_new(T),
+	forall(between(1, 1000, I), trie_insert(T, f(I, g(I)), I)),
+	findall(K-V, trie_gen(T, K, V), All0),
+	msort(All0, All),
+	findall(K-V, ( between(0, 2, I),
+		       trie_gen_partition(T, 3, I, K, V)
+		     ), Parts0),
+	msort(Parts0, Parts).
+test(gen_partition_bound, Count == 1) :-
+	trie_new(T),
+	forall(between(1, 100, I), trie_insert(T, f(I, g(I)), I)),
+	aggregate_all(count,
+		      ( between(0, 3, I),
+			trie_gen_partition(T, 4, I, f(42, _))
+		      ), Count).
+test(gen_partition_single, Parts == [0-a]) :-
+	trie_new(T),
+	trie_insert(T, a),
+	findall(I-K, ( between(0, 2, I),
+		       trie_gen_partition(T, 3, I, K)
+		     ), Parts).
+test(gen_partition_index, error(domain_error(partition_index, 2))) :-
+	trie_new(T),
+	trie_gen_partition(T, 2, 2, _).
 
 :- if(current_prolog_flag(bounded, false)).
 data(Big) :- Big is random(1<<200).
@@ -186,6 +275,42 @@ data(f(X,X)).
 data([nice, list(of(terms))]).
 
 
+set_trie(Keys, T) :-
+	trie_new(T),
+	maplist(trie_insert(T), Keys).
+
+trie_keys(T, Keys) :-
+	findall(K, trie_gen(T, K), Keys0),
+	msort(Keys0, Keys).
+
+insert_thread(T, _, Id) :-
+	thread_create(insert_keys(T), Id).
+
+insert_keys(T) :-
+	aggregate_all(count,
+		      ( between(1, 2000, I),
+			trie_insert(T, k(I, f(I)), I)
+		      ), Count),
+	thread_exit(Count).
+
+update_keys(T) :-
+	forall(between(1, 20000, I),
+	       trie_update(T, k, v(I,I))).
+
+lookup_thread(T, _, Id) :-
+	thread_create(lookup_keys(T), Id).
+
+lookup_keys(T) :-
+	aggregate_all(count,
+		      ( between(1, 20000, _),
+			trie_lookup(T, k, V),
+			V \= v(I,I)
+		      ), Count),
+	thread_exit(Count).
+
+join_count(Id, Count) :-
+	thread_join(Id, exited(Count)).
+
 shared_list(N, t(List,N)) :-
 	length(List, N),
 	reverse(List, R),
@@ -0,0 +1,174 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(test_parallel_load,
+	  [ test_parallel_load/0
+	  ]).
+:- use_module(library(plunit)).
+:- use_module(library(lists)).
+
+/** <module> Test load_files/2 using the parallel(Spec) option
+*/
+
+test_parallel_load :-
+    run_tests([ parallel_load
+	      ]).
+
+:- dynamic parallel_terms/2.
+
+:- multifile user:message_hook/3.
+
+user:message_hook(load_file(parallel(File, Count)), silent, _) :-
+    assertz(test_parallel_load:parallel_terms(File, Count)),
+    fail.
+
+:- begin_tests(parallel_load).
+
+test(facts, [Seq,N] == [Par,20000]) :-
+    load_compare(facts, 20000, none, none, Seq, Par, N).
+test(leading_directive, [Seq,N] == [Par,20000]) :-
+    load_compare(leading_directive, 20000, 0, directive, Seq, Par, N).
+test(directive, [Seq,N] == [Par,12345]) :-
+    load_compare(directive, 20000, 12345, directive, Seq, Par, N).
+test(rule_at_end, [Seq,N] == [Par,19990]) :-
+    load_compare(rule_at_end, 20000, 19990, rule, Seq, Par, N).
+test(expansion, [Seq,N] == [Par,5000]) :-
+    load_compare(expansion, 20000, 5000, expand, Seq, Par, N).
+test(utf8_position, [Seq,N] == [Par,12345]) :-
+    directive_position(utf8_position, [], Seq, _),
+    directive_position(utf8_position, [parallel(4)], Par, N).
+
+%!  load_compare(+Name, +Count, +Break, +Kind, -Seq, -Par, -N)
+%
+%   Write two copies of a file with Count facts, where the fact at
+%   index Break is followed by a term of Kind, and load one sequentially
+%   and the other in parallel. Seq and Par are the loaded facts with
+%   their line numbers and N is the number of terms that were read by
+%   the worker threads.
+
+load_compare(Name, Count, Break, Kind, Seq, Par, N) :-
+    loaded_facts(Name, Count, Break, Kind, [], Seq, _),
+    loaded_facts(Name, Count, Break, Kind, [parallel(4)], Par, N).
+
+loaded_facts(Name, Count, Break, Kind, Options, Facts, N) :-
+    tmp_file(Name, Tmp),
+    file_name_extension(Tmp, pl, File),
+    gensym(Name, Module),
+    (   Kind == expand
+    ->  assertz((Module:term_expansion(f(Break,T,S,L),
+				       [f(Break,T,S,L), (:- true)])))
+    ;   true
+    ),
+    retractall(parallel_terms(_, _)),
+    setup_call_cleanup(
+	write_facts(File, Count, Break, Kind),
+	( load_files(Module:File, [silent(true)|Options]),
+	  findall(f(I,T,S,L)-Line,
+		  ( clause(Module:f(I,T,S,L), true, Ref),
+		    clause_property(Ref, line_count(Line))
+		  ),
+		  Facts),
+	  (   parallel_terms(File, N)
+	  ->  true
+	  ;   N = 0
+	  )
+	),
+	delete_file(File)).
+
+write_facts(File, Count, Break, Kind) :-
+    setup_call_cleanup(
+	open(File, write, Out),
+	( (   Break == 0
+	  ->  write_break(Out, Kind)
+	  ;   true
+	  ),
+	  forall(between(1, Count, I),
+		 ( format(Out, 'f(~d, ~q, "~w", ~w).~n',
+			  [I, item(I), I, [I,a]]),
+		   (   I == Break
+		   ->  write_break(Out, Kind)
+		   ;   true
+		   )
+		 ))
+	),
+	close(Out)).
+
+write_break(Out, directive) :-
+    format(Out, ':- discontiguous f/4.~n', []).
+write_break(Out, rule) :-
+    format(Out, 'f(0, rule, "0", []) :- true.~n', []).
+write_break(_, expand).
+
+:- dynamic directive_pos/1.
+
+%!  directive_position(+Name, +Options, -Pos, -N)
+%
+%   Load a UTF-8 file with non-ASCII facts followed by a directive that
+%   records its term position.  Pos is this position, which depends on
+%   the stream position where sequential reading continues.
+
+directive_position(Name, Options, Pos, N) :-
+    tmp_file(Name, Tmp),
+    file_name_extension(Tmp, pl, File),
+    gensym(Name, Module),
+    retractall(parallel_terms(_, _)),
+    retractall(directive_pos(_)),
+    setup_call_cleanup(
+	write_utf8_facts(File, 20000, 12345),
+	( load_files(Module:File, [silent(true)|Options]),
+	  directive_pos(Pos),
+	  (   parallel_terms(File, N)
+	  ->  true
+	  ;   N = 0
+	  )
+	),
+	delete_file(File)).
+
+write_utf8_facts(File, Count, Break) :-
+    setup_call_cleanup(
+	open(File, write, Out, [encoding(utf8)]),
+	( format(Out, ':- encoding(utf8).~n', []),
+	  forall(between(1, Count, I),
+		 ( format(Out, 'g(~d, \'\u00e4\u00f6\u00fc\u20ac\').~n', [I]),
+		   (   I == Break
+		   ->  format(Out, ':- prolog_load_context(term_position, P), \c
+				   assertz(test_parallel_load:directive_pos(P)).~n',
+			      [])
+		   ;   true
+		   )
+		 ))
+	),
+	close(Out)).
+
+:- end_tests(parallel_load).